@@ -0,0 +1,95 @@
+// Turns the AL and ALC calls that follow into OPENAL_CALL (OpenALCalls.h) so they are counted.
+// For the block headers only: include it after their own includes, and OpenALCallMacrosEnd.h
+// at their end. No include guard, as every block header defines and undefines them in turn.
+
+#define alEnable(...)                   OPENAL_CALL(alEnable, __VA_ARGS__)
+#define alDisable(...)                  OPENAL_CALL(alDisable, __VA_ARGS__)
+#define alIsEnabled(...)                OPENAL_CALL(alIsEnabled, __VA_ARGS__)
+#define alGetString(...)                OPENAL_CALL(alGetString, __VA_ARGS__)
+#define alGetBooleanv(...)              OPENAL_CALL(alGetBooleanv, __VA_ARGS__)
+#define alGetIntegerv(...)              OPENAL_CALL(alGetIntegerv, __VA_ARGS__)
+#define alGetFloatv(...)                OPENAL_CALL(alGetFloatv, __VA_ARGS__)
+#define alGetDoublev(...)               OPENAL_CALL(alGetDoublev, __VA_ARGS__)
+#define alGetBoolean(...)               OPENAL_CALL(alGetBoolean, __VA_ARGS__)
+#define alGetInteger(...)               OPENAL_CALL(alGetInteger, __VA_ARGS__)
+#define alGetFloat(...)                 OPENAL_CALL(alGetFloat, __VA_ARGS__)
+#define alGetDouble(...)                OPENAL_CALL(alGetDouble, __VA_ARGS__)
+#define alGetError(...)                 OPENAL_CALL(alGetError, __VA_ARGS__)
+#define alIsExtensionPresent(...)       OPENAL_CALL(alIsExtensionPresent, __VA_ARGS__)
+#define alGetProcAddress(...)           OPENAL_CALL(alGetProcAddress, __VA_ARGS__)
+#define alGetEnumValue(...)             OPENAL_CALL(alGetEnumValue, __VA_ARGS__)
+#define alDopplerFactor(...)            OPENAL_CALL(alDopplerFactor, __VA_ARGS__)
+#define alSpeedOfSound(...)             OPENAL_CALL(alSpeedOfSound, __VA_ARGS__)
+#define alDistanceModel(...)            OPENAL_CALL(alDistanceModel, __VA_ARGS__)
+
+#define alListenerf(...)                OPENAL_CALL(alListenerf, __VA_ARGS__)
+#define alListener3f(...)               OPENAL_CALL(alListener3f, __VA_ARGS__)
+#define alListenerfv(...)               OPENAL_CALL(alListenerfv, __VA_ARGS__)
+#define alListeneri(...)                OPENAL_CALL(alListeneri, __VA_ARGS__)
+#define alListener3i(...)               OPENAL_CALL(alListener3i, __VA_ARGS__)
+#define alListeneriv(...)               OPENAL_CALL(alListeneriv, __VA_ARGS__)
+#define alGetListenerf(...)             OPENAL_CALL(alGetListenerf, __VA_ARGS__)
+#define alGetListener3f(...)            OPENAL_CALL(alGetListener3f, __VA_ARGS__)
+#define alGetListenerfv(...)            OPENAL_CALL(alGetListenerfv, __VA_ARGS__)
+#define alGetListeneri(...)             OPENAL_CALL(alGetListeneri, __VA_ARGS__)
+#define alGetListener3i(...)            OPENAL_CALL(alGetListener3i, __VA_ARGS__)
+#define alGetListeneriv(...)            OPENAL_CALL(alGetListeneriv, __VA_ARGS__)
+
+#define alGenSources(...)               OPENAL_CALL(alGenSources, __VA_ARGS__)
+#define alDeleteSources(...)            OPENAL_CALL(alDeleteSources, __VA_ARGS__)
+#define alIsSource(...)                 OPENAL_CALL(alIsSource, __VA_ARGS__)
+#define alSourcef(...)                  OPENAL_CALL(alSourcef, __VA_ARGS__)
+#define alSource3f(...)                 OPENAL_CALL(alSource3f, __VA_ARGS__)
+#define alSourcefv(...)                 OPENAL_CALL(alSourcefv, __VA_ARGS__)
+#define alSourcei(...)                  OPENAL_CALL(alSourcei, __VA_ARGS__)
+#define alSource3i(...)                 OPENAL_CALL(alSource3i, __VA_ARGS__)
+#define alSourceiv(...)                 OPENAL_CALL(alSourceiv, __VA_ARGS__)
+#define alGetSourcef(...)               OPENAL_CALL(alGetSourcef, __VA_ARGS__)
+#define alGetSource3f(...)              OPENAL_CALL(alGetSource3f, __VA_ARGS__)
+#define alGetSourcefv(...)              OPENAL_CALL(alGetSourcefv, __VA_ARGS__)
+#define alGetSourcei(...)               OPENAL_CALL(alGetSourcei, __VA_ARGS__)
+#define alGetSource3i(...)              OPENAL_CALL(alGetSource3i, __VA_ARGS__)
+#define alGetSourceiv(...)              OPENAL_CALL(alGetSourceiv, __VA_ARGS__)
+#define alSourcePlayv(...)              OPENAL_CALL(alSourcePlayv, __VA_ARGS__)
+#define alSourceStopv(...)              OPENAL_CALL(alSourceStopv, __VA_ARGS__)
+#define alSourceRewindv(...)            OPENAL_CALL(alSourceRewindv, __VA_ARGS__)
+#define alSourcePausev(...)             OPENAL_CALL(alSourcePausev, __VA_ARGS__)
+#define alSourcePlay(...)               OPENAL_CALL(alSourcePlay, __VA_ARGS__)
+#define alSourceStop(...)               OPENAL_CALL(alSourceStop, __VA_ARGS__)
+#define alSourceRewind(...)             OPENAL_CALL(alSourceRewind, __VA_ARGS__)
+#define alSourcePause(...)              OPENAL_CALL(alSourcePause, __VA_ARGS__)
+#define alSourceQueueBuffers(...)       OPENAL_CALL(alSourceQueueBuffers, __VA_ARGS__)
+#define alSourceUnqueueBuffers(...)     OPENAL_CALL(alSourceUnqueueBuffers, __VA_ARGS__)
+
+#define alGenBuffers(...)               OPENAL_CALL(alGenBuffers, __VA_ARGS__)
+#define alDeleteBuffers(...)            OPENAL_CALL(alDeleteBuffers, __VA_ARGS__)
+#define alIsBuffer(...)                 OPENAL_CALL(alIsBuffer, __VA_ARGS__)
+#define alBufferData(...)               OPENAL_CALL(alBufferData, __VA_ARGS__)
+#define alBufferf(...)                  OPENAL_CALL(alBufferf, __VA_ARGS__)
+#define alBuffer3f(...)                 OPENAL_CALL(alBuffer3f, __VA_ARGS__)
+#define alBufferfv(...)                 OPENAL_CALL(alBufferfv, __VA_ARGS__)
+#define alBufferi(...)                  OPENAL_CALL(alBufferi, __VA_ARGS__)
+#define alBuffer3i(...)                 OPENAL_CALL(alBuffer3i, __VA_ARGS__)
+#define alBufferiv(...)                 OPENAL_CALL(alBufferiv, __VA_ARGS__)
+#define alGetBufferf(...)               OPENAL_CALL(alGetBufferf, __VA_ARGS__)
+#define alGetBuffer3f(...)              OPENAL_CALL(alGetBuffer3f, __VA_ARGS__)
+#define alGetBufferfv(...)              OPENAL_CALL(alGetBufferfv, __VA_ARGS__)
+#define alGetBufferi(...)               OPENAL_CALL(alGetBufferi, __VA_ARGS__)
+#define alGetBuffer3i(...)              OPENAL_CALL(alGetBuffer3i, __VA_ARGS__)
+#define alGetBufferiv(...)              OPENAL_CALL(alGetBufferiv, __VA_ARGS__)
+
+#define alcCreateContext(...)           OPENAL_CALL(alcCreateContext, __VA_ARGS__)
+#define alcMakeContextCurrent(...)      OPENAL_CALL(alcMakeContextCurrent, __VA_ARGS__)
+#define alcProcessContext(...)          OPENAL_CALL(alcProcessContext, __VA_ARGS__)
+#define alcSuspendContext(...)          OPENAL_CALL(alcSuspendContext, __VA_ARGS__)
+#define alcDestroyContext(...)          OPENAL_CALL(alcDestroyContext, __VA_ARGS__)
+#define alcGetCurrentContext(...)       OPENAL_CALL(alcGetCurrentContext, __VA_ARGS__)
+#define alcGetContextsDevice(...)       OPENAL_CALL(alcGetContextsDevice, __VA_ARGS__)
+#define alcOpenDevice(...)              OPENAL_CALL(alcOpenDevice, __VA_ARGS__)
+#define alcCloseDevice(...)             OPENAL_CALL(alcCloseDevice, __VA_ARGS__)
+#define alcGetError(...)                OPENAL_CALL(alcGetError, __VA_ARGS__)
+#define alcIsExtensionPresent(...)      OPENAL_CALL(alcIsExtensionPresent, __VA_ARGS__)
+#define alcGetProcAddress(...)          OPENAL_CALL(alcGetProcAddress, __VA_ARGS__)
+#define alcGetEnumValue(...)            OPENAL_CALL(alcGetEnumValue, __VA_ARGS__)
+#define alcGetString(...)               OPENAL_CALL(alcGetString, __VA_ARGS__)
+#define alcGetIntegerv(...)             OPENAL_CALL(alcGetIntegerv, __VA_ARGS__)
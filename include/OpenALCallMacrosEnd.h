@@ -0,0 +1,93 @@
+// Undefines the macros of OpenALCallMacros.h at the end of a block header
+
+#undef alEnable
+#undef alDisable
+#undef alIsEnabled
+#undef alGetString
+#undef alGetBooleanv
+#undef alGetIntegerv
+#undef alGetFloatv
+#undef alGetDoublev
+#undef alGetBoolean
+#undef alGetInteger
+#undef alGetFloat
+#undef alGetDouble
+#undef alGetError
+#undef alIsExtensionPresent
+#undef alGetProcAddress
+#undef alGetEnumValue
+#undef alDopplerFactor
+#undef alSpeedOfSound
+#undef alDistanceModel
+
+#undef alListenerf
+#undef alListener3f
+#undef alListenerfv
+#undef alListeneri
+#undef alListener3i
+#undef alListeneriv
+#undef alGetListenerf
+#undef alGetListener3f
+#undef alGetListenerfv
+#undef alGetListeneri
+#undef alGetListener3i
+#undef alGetListeneriv
+
+#undef alGenSources
+#undef alDeleteSources
+#undef alIsSource
+#undef alSourcef
+#undef alSource3f
+#undef alSourcefv
+#undef alSourcei
+#undef alSource3i
+#undef alSourceiv
+#undef alGetSourcef
+#undef alGetSource3f
+#undef alGetSourcefv
+#undef alGetSourcei
+#undef alGetSource3i
+#undef alGetSourceiv
+#undef alSourcePlayv
+#undef alSourceStopv
+#undef alSourceRewindv
+#undef alSourcePausev
+#undef alSourcePlay
+#undef alSourceStop
+#undef alSourceRewind
+#undef alSourcePause
+#undef alSourceQueueBuffers
+#undef alSourceUnqueueBuffers
+
+#undef alGenBuffers
+#undef alDeleteBuffers
+#undef alIsBuffer
+#undef alBufferData
+#undef alBufferf
+#undef alBuffer3f
+#undef alBufferfv
+#undef alBufferi
+#undef alBuffer3i
+#undef alBufferiv
+#undef alGetBufferf
+#undef alGetBuffer3f
+#undef alGetBufferfv
+#undef alGetBufferi
+#undef alGetBuffer3i
+#undef alGetBufferiv
+
+#undef alcCreateContext
+#undef alcMakeContextCurrent
+#undef alcProcessContext
+#undef alcSuspendContext
+#undef alcDestroyContext
+#undef alcGetCurrentContext
+#undef alcGetContextsDevice
+#undef alcOpenDevice
+#undef alcCloseDevice
+#undef alcGetError
+#undef alcIsExtensionPresent
+#undef alcGetProcAddress
+#undef alcGetEnumValue
+#undef alcGetString
+#undef alcGetIntegerv
@@ -0,0 +1,226 @@
+#pragma once
+
+// Routes the AL and ALC calls made by the block through OPENAL_CALL so they can be counted.
+// The block headers include OpenALCallMacros.h after their own includes, which makes every AL
+// call in them an OPENAL_CALL, and OpenALCallMacrosEnd.h at their end, so the macros never
+// reach code that includes the block. They are function-like macros that only replace calls,
+// so the AL prototypes and any function pointers taken to them are unaffected.
+//
+// Define OPENAL_TRACE_CALLS to also record the name, caller and duration of every call into
+// a ring buffer per thread (OPENAL_TRACE_CAPACITY calls, 65536 by default), and write them
+// out with DumpTrace as a Chrome trace (chrome://tracing or https://ui.perfetto.dev).
+// Without it the tracing compiles away and DumpTrace writes an empty trace.
+
+#include "AL/al.h"
+#include "AL/alc.h"
+
+#include <ostream>
+
+#ifdef OPENAL_TRACE_CALLS
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#endif
+
+// vc2012 and vc2013 do not support the C++11 thread_local keyword
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define OPENAL_THREAD_LOCAL __declspec(thread)
+#else
+#define OPENAL_THREAD_LOCAL thread_local
+#endif
+
+namespace OpenAL
+{
+
+// AL and ALC calls made on the calling thread; wraps around
+extern OPENAL_THREAD_LOCAL unsigned int t_numAlCalls;
+
+inline void CountAlCall()
+{
+    ++t_numAlCalls;
+}
+
+#ifdef OPENAL_TRACE_CALLS
+
+#ifndef OPENAL_TRACE_CAPACITY
+#define OPENAL_TRACE_CAPACITY 65536
+#endif
+
+// One traced call; times are steady clock nanoseconds
+struct TraceEvent
+{
+    const char* name;
+    const char* caller;
+    int64_t     start;
+    int64_t     duration;
+};
+
+// The most recent calls made on one thread. Only the owning thread adds to it; the lock is
+// uncontended except while a dump is reading it.
+class TraceRing
+{
+public:
+    TraceRing(unsigned int threadId) :
+        m_events(OPENAL_TRACE_CAPACITY), m_next(0), m_count(0), m_threadId(threadId)
+    {
+    }
+
+    void Add(const TraceEvent& event)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events[m_next] = event;
+        m_next  = (m_next + 1) % m_events.size();
+        m_count = m_count < m_events.size() ? m_count + 1 : m_count;
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_next  = 0;
+        m_count = 0;
+    }
+
+    // Oldest first
+    std::vector<TraceEvent> GetEvents()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<TraceEvent> events;
+        events.reserve(m_count);
+        size_t first = (m_next + m_events.size() - m_count) % m_events.size();
+        for (size_t i = 0; i < m_count; ++i)
+        {
+            events.push_back(m_events[(first + i) % m_events.size()]);
+        }
+        return events;
+    }
+
+    unsigned int GetThreadId() const { return m_threadId; }
+
+private:
+    std::mutex              m_mutex;
+    std::vector<TraceEvent> m_events;
+    size_t                  m_next;
+    size_t                  m_count;
+    unsigned int            m_threadId;
+};
+
+// The ring of the calling thread, created on its first traced call
+extern OPENAL_THREAD_LOCAL TraceRing* t_pTraceRing;
+
+// Every ring created so far; rings outlive their threads so late dumps still see them
+struct TraceRegistry
+{
+    std::mutex                  mutex;
+    std::vector<std::unique_ptr<TraceRing>> rings;
+};
+
+inline TraceRegistry& GetTraceRegistry()
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+inline int64_t GetTraceTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Times one call from construction to the end of the full expression it is created in
+class TraceScope
+{
+public:
+    TraceScope(const char* name, const char* caller) :
+        m_name(name), m_caller(caller), m_start(GetTraceTime())
+    {
+    }
+
+    ~TraceScope()
+    {
+        TraceEvent event = { m_name, m_caller, m_start, GetTraceTime() - m_start };
+        if (t_pTraceRing == NULL)
+        {
+            TraceRegistry& registry = GetTraceRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            t_pTraceRing = new TraceRing(static_cast<unsigned int>(registry.rings.size()));
+            registry.rings.push_back(std::unique_ptr<TraceRing>(t_pTraceRing));
+        }
+        t_pTraceRing->Add(event);
+    }
+
+private:
+    const char* m_name;
+    const char* m_caller;
+    int64_t     m_start;
+};
+
+// Writes the calls recorded on every thread as Chrome trace event JSON
+inline void DumpTrace(std::ostream& out)
+{
+    TraceRegistry& registry = GetTraceRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::vector<std::vector<TraceEvent> > threads;
+    int64_t origin = INT64_MAX;
+    for (const std::unique_ptr<TraceRing>& pRing : registry.rings)
+    {
+        threads.push_back(pRing->GetEvents());
+        if (!threads.back().empty())
+        {
+            origin = std::min(origin, threads.back().front().start);
+        }
+    }
+
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        for (const TraceEvent& event : threads[i])
+        {
+            out << (first ? "\n" : ",\n")
+                << "{\"name\":\"" << event.name << "\",\"cat\":\"al\",\"ph\":\"X\""
+                << ",\"ts\":"  << (event.start - origin) / 1000.0
+                << ",\"dur\":" << event.duration / 1000.0
+                << ",\"pid\":0,\"tid\":" << registry.rings[i]->GetThreadId()
+                << ",\"args\":{\"caller\":\"" << event.caller << "\"}}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+}
+
+// Forgets the calls recorded so far on every thread
+inline void ClearTrace()
+{
+    TraceRegistry& registry = GetTraceRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const std::unique_ptr<TraceRing>& pRing : registry.rings)
+    {
+        pRing->Clear();
+    }
+}
+
+#else
+
+inline void DumpTrace(std::ostream& out)
+{
+    out << "{\"traceEvents\":[]}\n";
+}
+
+inline void ClearTrace()
+{
+}
+
+#endif
+
+} // namespace OpenAL
+
+// Calls an AL or ALC entry point, or an extension function pointer, e.g.
+// OPENAL_CALL(m_alGetSourcei64vSOFT, source, AL_SAMPLE_OFFSET_LATENCY_SOFT, values)
+#ifdef OPENAL_TRACE_CALLS
+#define OPENAL_CALL(function, ...) (::OpenAL::TraceScope(#function, __FUNCTION__), ::OpenAL::CountAlCall(), function(__VA_ARGS__))
+#else
+#define OPENAL_CALL(function, ...) (::OpenAL::CountAlCall(), function(__VA_ARGS__))
+#endif
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace OpenAL
+{
+
+// Where playback of a voice is audible right now, after output latency
+struct PlaybackPosition
+{
+    int64_t samples;    // sample frame within the buffer
+    double  seconds;
+    bool    playing;    // false once stopped; paused voices report their held position
+};
+
+// Where a looping voice is after playing frame frames into a buffer that repeats
+// [loopStart, loopEnd) once it reaches loopEnd
+inline double WrapLoopFrame(double frame, double loopStart, double loopEnd)
+{
+    if (frame < loopEnd || loopEnd <= loopStart)
+    {
+        return frame;
+    }
+    return loopStart + std::fmod(frame - loopStart, loopEnd - loopStart);
+}
+
+// Latency-corrected playback position of a voice. Written by the thread updating the
+// context and read lock-free from any other thread (a sequence lock over relaxed atomics);
+// readers extrapolate from the last update so a render loop can sample it every frame.
+class VoiceClock
+{
+public:
+    VoiceClock() :
+        m_sequence(0), m_deviceTime(0.0), m_audibleFrame(0.0), m_framesPerSecond(0.0),
+        m_frequency(0.0), m_lengthFrames(0.0), m_loopStart(0.0), m_loopEnd(0.0), m_looping(false), m_active(false)
+    {
+    }
+
+    // audibleFrame is the frame heard at deviceTime, framesPerSecond is 0 while paused. A
+    // looping voice repeats [loopStart, loopEnd) once past loopEnd, or the whole buffer if
+    // loopEnd is 0.
+    void Publish(double deviceTime, double audibleFrame, double framesPerSecond, double frequency, double lengthFrames, bool looping,
+                 double loopStart = 0.0, double loopEnd = 0.0)
+    {
+        unsigned int sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_deviceTime.store(deviceTime,           std::memory_order_relaxed);
+        m_audibleFrame.store(audibleFrame,       std::memory_order_relaxed);
+        m_framesPerSecond.store(framesPerSecond, std::memory_order_relaxed);
+        m_frequency.store(frequency,             std::memory_order_relaxed);
+        m_lengthFrames.store(lengthFrames,       std::memory_order_relaxed);
+        m_loopStart.store(loopStart,             std::memory_order_relaxed);
+        m_loopEnd.store(loopEnd,                 std::memory_order_relaxed);
+        m_looping.store(looping,                 std::memory_order_relaxed);
+        m_active.store(true,                     std::memory_order_relaxed);
+
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void Reset()
+    {
+        unsigned int sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_active.store(false, std::memory_order_relaxed);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    PlaybackPosition Read(double deviceTime) const
+    {
+        double  publishTime, audibleFrame, framesPerSecond, frequency, lengthFrames, loopStart, loopEnd;
+        bool    looping, active;
+        unsigned int before, after;
+        do
+        {
+            before          = m_sequence.load(std::memory_order_acquire);
+            publishTime     = m_deviceTime.load(std::memory_order_relaxed);
+            audibleFrame    = m_audibleFrame.load(std::memory_order_relaxed);
+            framesPerSecond = m_framesPerSecond.load(std::memory_order_relaxed);
+            frequency       = m_frequency.load(std::memory_order_relaxed);
+            lengthFrames    = m_lengthFrames.load(std::memory_order_relaxed);
+            loopStart       = m_loopStart.load(std::memory_order_relaxed);
+            loopEnd         = m_loopEnd.load(std::memory_order_relaxed);
+            looping         = m_looping.load(std::memory_order_relaxed);
+            active          = m_active.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after           = m_sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        PlaybackPosition position = { 0, 0.0, false };
+        if (!active)
+        {
+            return position;
+        }
+
+        double frame = audibleFrame + (deviceTime - publishTime) * framesPerSecond;
+        if (looping && loopEnd > loopStart)
+        {
+            frame = WrapLoopFrame(frame, loopStart, loopEnd);
+        }
+        else if (looping && lengthFrames > 0.0)
+        {
+            frame = std::fmod(frame, lengthFrames);
+            if (frame < 0.0)
+            {
+                frame += lengthFrames;
+            }
+        }
+        frame = std::max(0.0, std::min(frame, lengthFrames));
+
+        position.samples = static_cast<int64_t>(frame);
+        position.seconds = frequency > 0.0 ? frame / frequency : 0.0;
+        position.playing = looping || frame < lengthFrames;
+        return position;
+    }
+
+private:
+    std::atomic<unsigned int>   m_sequence;
+    std::atomic<double>         m_deviceTime;
+    std::atomic<double>         m_audibleFrame;
+    std::atomic<double>         m_framesPerSecond;
+    std::atomic<double>         m_frequency;
+    std::atomic<double>         m_lengthFrames;
+    std::atomic<double>         m_loopStart;
+    std::atomic<double>         m_loopEnd;
+    std::atomic<bool>           m_looping;
+    std::atomic<bool>           m_active;
+};
+
+} // namespace OpenAL
@@ -0,0 +1,3590 @@
+#pragma once
+
+// The engine: devices, contexts, buffers and sounds. Depends only on OpenAL and the standard
+// library; OpenAL.h adds the Cinder adapter on top.
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "AL/alext.h"
+
+#include "OpenALCalls.h"
+#include "OpenALErrors.h"
+#include "OpenALStats.h"
+#include "OpenALClock.h"
+#include "OpenALEffects.h"
+#include "OpenALEmitters.h"
+#include "OpenALMath.h"
+#include "OpenALWav.h"
+#include "OpenALZones.h"
+
+#include <iostream>
+#include <sstream>
+#include <deque>
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <type_traits>
+
+#include "OpenALCallMacros.h"
+
+namespace OpenAL
+{
+
+class Sound;
+class AudioDevice;
+class AudioContext;
+
+// Device and context created by InitOpenAL; sounds created without an explicit context play here
+extern AudioDevice*         g_pDefaultDevice;
+extern AudioContext*        g_pDefaultContext;
+
+// The context most recently made current on the calling thread
+extern OPENAL_THREAD_LOCAL AudioContext* t_pCurrentContext;
+
+// The AL context the block last made current for the process, where there is no
+// ALC_EXT_thread_local_context; contexts made current outside the block are not seen
+extern std::atomic<ALCcontext*> g_pCurrentAlContext;
+
+
+// Output format of a loopback device (ALC_SOFT_loopback), e.g. { 48000, ALC_STEREO_SOFT, ALC_SHORT_SOFT }
+struct LoopbackFormat
+{
+    ALCsizei    frequency;
+    ALCenum     channels;
+    ALCenum     type;
+};
+
+// An open playback or loopback device; owns every context created on it
+class AudioDevice
+{
+public:
+    // With openAsync the device is opened on a background thread and the constructor returns
+    // at once. Contexts can be created, buffers loaded and sounds played meanwhile; contexts
+    // come up and queued plays start in the first AudioContext::Update after it has opened.
+    AudioDevice(const ALCchar* deviceName = NULL, bool openAsync = false) :
+        m_pAlDevice(NULL), m_isOpening(false), m_alcSetThreadContext(NULL), m_openTime(std::chrono::steady_clock::now()), m_frequency(0),
+        m_hasDisconnect(false), m_reopenInterval(0.5), m_lastReopenAttempt(0.0), m_numReopens(0),
+        m_deviceName(deviceName ? deviceName : ""), m_hasDeviceName(deviceName != NULL), m_pOldDevice(NULL), m_deviceGeneration(0), m_numPendingMoves(0),
+        m_loopback(false), m_frameSize(0), m_renderedFrames(0), m_alcLoopbackOpenDeviceSOFT(NULL), m_alcIsRenderFormatSupportedSOFT(NULL), m_alcRenderSamplesSOFT(NULL)
+    {
+        if (openAsync)
+        {
+            // Some backends take hundreds of milliseconds to open
+            std::string name    = deviceName ? deviceName : "";
+            bool        hasName = deviceName != NULL;
+            m_opening = std::async(std::launch::async, [name, hasName]() { return alcOpenDevice(hasName ? name.c_str() : NULL); });
+            m_isOpening = true;
+            return;
+        }
+
+        try
+        {
+            m_pAlDevice = alcOpenDevice(deviceName);
+            if (m_pAlDevice == NULL)
+            {
+                throw ("Error occurred creating AL device");
+            }
+
+            LoadExtensions();
+        }
+        catch(const char* error)
+        {
+            ReportError(error);
+        }
+    }
+
+    // Opens a loopback device that mixes only when Render is called, as fast as the caller
+    // pulls frames, with no audio hardware involved
+    AudioDevice(const LoopbackFormat& format) :
+        m_pAlDevice(NULL), m_isOpening(false), m_alcSetThreadContext(NULL), m_openTime(std::chrono::steady_clock::now()), m_frequency(0),
+        m_hasDisconnect(false), m_reopenInterval(0.5), m_lastReopenAttempt(0.0), m_numReopens(0),
+        m_hasDeviceName(false), m_pOldDevice(NULL), m_deviceGeneration(0), m_numPendingMoves(0),
+        m_loopback(true), m_loopbackFormat(format), m_frameSize(0), m_renderedFrames(0), m_alcLoopbackOpenDeviceSOFT(NULL), m_alcIsRenderFormatSupportedSOFT(NULL), m_alcRenderSamplesSOFT(NULL)
+    {
+        try
+        {
+            if (!alcIsExtensionPresent(NULL, "ALC_SOFT_loopback"))
+            {
+                throw ("ALC_SOFT_loopback is not supported");
+            }
+
+            m_alcLoopbackOpenDeviceSOFT      = reinterpret_cast<LPALCLOOPBACKOPENDEVICESOFT>(alcGetProcAddress(NULL, "alcLoopbackOpenDeviceSOFT"));
+            m_alcIsRenderFormatSupportedSOFT = reinterpret_cast<LPALCISRENDERFORMATSUPPORTEDSOFT>(alcGetProcAddress(NULL, "alcIsRenderFormatSupportedSOFT"));
+            m_alcRenderSamplesSOFT           = reinterpret_cast<LPALCRENDERSAMPLESSOFT>(alcGetProcAddress(NULL, "alcRenderSamplesSOFT"));
+            if (!m_alcLoopbackOpenDeviceSOFT || !m_alcIsRenderFormatSupportedSOFT || !m_alcRenderSamplesSOFT)
+            {
+                throw ("ALC_SOFT_loopback entry points are missing");
+            }
+
+            m_pAlDevice = OpenLoopbackDevice();
+            if (m_pAlDevice == NULL)
+            {
+                throw ("Error occurred creating AL loopback device, or its render format is not supported");
+            }
+
+            m_frameSize = GetChannelCount(format.channels) * GetSampleSize(format.type);
+
+            // Contexts on a loopback device must be created with its render format
+            ALCint attributes[] = {
+                ALC_FORMAT_CHANNELS_SOFT,   format.channels,
+                ALC_FORMAT_TYPE_SOFT,       format.type,
+                ALC_FREQUENCY,              format.frequency
+            };
+            m_formatAttributes.assign(attributes, attributes + 6);
+
+            LoadExtensions();
+            m_frequency = format.frequency;
+        }
+        catch(const char* error)
+        {
+            ReportError(error);
+        }
+    }
+
+    ~AudioDevice()
+    {
+        if (m_opening.valid())
+        {
+            // Still opening; wait for it so the device can be closed
+            m_pAlDevice = m_opening.get();
+            m_isOpening = false;
+        }
+
+        while (!m_contexts.empty())
+        {
+            DestroyContext(m_contexts.back());
+        }
+
+        if (m_pAlDevice)
+        {
+            alcCloseDevice(m_pAlDevice);
+        }
+        if (m_pOldDevice)
+        {
+            alcCloseDevice(m_pOldDevice);
+        }
+    }
+
+    AudioContext*   CreateContext(const ALCint* attributes = NULL);
+    void            DestroyContext(AudioContext* pContext);
+
+    bool            IsOpen() const          { return m_pAlDevice != NULL; }
+
+    // True while a device opened with openAsync is not yet ready for use
+    bool            IsOpening() const       { return m_isOpening; }
+    ALCdevice*      GetAlDevice() const     { return m_pAlDevice; }
+
+    // Output sample rate of the device
+    ALCint          GetFrequency() const    { return m_frequency; }
+
+    // Seconds elapsed on the device since it was opened; the timeline used for scheduled playback.
+    // A loopback device only advances as frames are rendered. Monotonic and safe to read from any thread.
+    double GetTime() const
+    {
+        if (m_loopback)
+        {
+            return m_frequency > 0 ? static_cast<double>(m_renderedFrames.load(std::memory_order_relaxed)) / m_frequency : 0.0;
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_openTime).count();
+    }
+
+    bool            IsLoopback() const      { return m_loopback; }
+
+    // Bytes per rendered frame of a loopback device
+    ALCsizei        GetFrameSize() const    { return m_frameSize; }
+    int64_t         GetRenderedFrames() const { return m_renderedFrames.load(std::memory_order_relaxed); }
+
+    // Mixes the next frames of a loopback device into pBuffer (frames * GetFrameSize() bytes).
+    // Contexts should be updated between renders just as they are once per frame in real time.
+    void Render(void* pBuffer, ALCsizei frames)
+    {
+        if (!m_loopback || m_pAlDevice == NULL)
+        {
+            return;
+        }
+        OPENAL_CALL(m_alcRenderSamplesSOFT, m_pAlDevice, pBuffer, frames);
+        m_renderedFrames.fetch_add(frames, std::memory_order_relaxed);
+    }
+
+    const std::vector<AudioContext*>& GetContexts() const { return m_contexts; }
+
+    // Polls ALC_CONNECTED and, if the output has gone away, reopens the device. Called by
+    // AudioContext::Update; returns false while the device is disconnected and could not yet
+    // be reopened. Contexts updated on different threads take the device lock here, so only
+    // one of them reopens the device.
+    bool CheckConnection();
+
+    // Opens the device again, by the name it was first opened with (a loopback device with
+    // its render format, carrying on its clock), and swaps it in. Each context then moves to
+    // it in its own next Update, keeping buffers and voices; until then it keeps running on
+    // the old device, which is closed once the last context has left it. Returns false if
+    // the device could not be opened, or contexts are still moving from the last reopen.
+    bool Reopen()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return ReopenDevice();
+    }
+
+    // Minimum seconds between attempts to reopen a disconnected device
+    void            SetReopenInterval(double seconds)   { m_reopenInterval = seconds; }
+    unsigned int    GetNumReopens() const               { return m_numReopens; }
+
+private:
+    std::atomic<ALCdevice*>     m_pAlDevice;
+    std::vector<AudioContext*>  m_contexts;
+    std::future<ALCdevice*>     m_opening;
+    std::atomic<bool>           m_isOpening;
+    PFNALCSETTHREADCONTEXTPROC  m_alcSetThreadContext;
+    std::chrono::steady_clock::time_point m_openTime;
+    ALCint                      m_frequency;
+    bool                        m_hasDisconnect;
+    double                      m_reopenInterval;
+    double                      m_lastReopenAttempt;
+    unsigned int                m_numReopens;
+
+    // What a reopen opens again, and the device it replaced until every context has moved
+    std::string                 m_deviceName;
+    bool                        m_hasDeviceName;
+    ALCdevice*                  m_pOldDevice;
+    std::atomic<unsigned int>   m_deviceGeneration;     // incremented by each reopen
+    size_t                      m_numPendingMoves;      // contexts still on m_pOldDevice
+
+    bool                        m_loopback;
+    LoopbackFormat              m_loopbackFormat;
+    ALCsizei                    m_frameSize;
+    std::atomic<int64_t>        m_renderedFrames;
+    std::vector<ALCint>         m_formatAttributes;
+    LPALCLOOPBACKOPENDEVICESOFT         m_alcLoopbackOpenDeviceSOFT;
+    LPALCISRENDERFORMATSUPPORTEDSOFT    m_alcIsRenderFormatSupportedSOFT;
+    LPALCRENDERSAMPLESSOFT              m_alcRenderSamplesSOFT;
+
+    // Held while checking the connection, reopening and moving contexts
+    std::mutex                  m_mutex;
+
+    static ALCsizei GetChannelCount(ALCenum channels)
+    {
+        switch (channels)
+        {
+            case ALC_MONO_SOFT:     return 1;
+            case ALC_STEREO_SOFT:   return 2;
+            case ALC_QUAD_SOFT:     return 4;
+            case ALC_5POINT1_SOFT:  return 6;
+            case ALC_6POINT1_SOFT:  return 7;
+            case ALC_7POINT1_SOFT:  return 8;
+            default:                return 0;
+        }
+    }
+
+    static ALCsizei GetSampleSize(ALCenum type)
+    {
+        switch (type)
+        {
+            case ALC_BYTE_SOFT:
+            case ALC_UNSIGNED_BYTE_SOFT:    return 1;
+            case ALC_SHORT_SOFT:
+            case ALC_UNSIGNED_SHORT_SOFT:   return 2;
+            case ALC_INT_SOFT:
+            case ALC_UNSIGNED_INT_SOFT:
+            case ALC_FLOAT_SOFT:            return 4;
+            default:                        return 0;
+        }
+    }
+
+    void LoadExtensions()
+    {
+        alcGetIntegerv(m_pAlDevice, ALC_FREQUENCY, 1, &m_frequency);
+
+        // Thread local contexts allow independent contexts to be driven from different threads
+        m_alcSetThreadContext = NULL;
+        if (alcIsExtensionPresent(m_pAlDevice, "ALC_EXT_thread_local_context"))
+        {
+            m_alcSetThreadContext = reinterpret_cast<PFNALCSETTHREADCONTEXTPROC>(alcGetProcAddress(m_pAlDevice, "alcSetThreadContext"));
+        }
+
+        // A loopback device has no output to lose
+        m_hasDisconnect = !m_loopback && alcIsExtensionPresent(m_pAlDevice, "ALC_EXT_disconnect") != ALC_FALSE;
+    }
+
+    // Takes the device from the background open once it is done and creates the contexts
+    // waiting on it; false until then. Called with the device lock held.
+    bool FinishOpen();
+
+    // Reopen with the device lock held
+    bool ReopenDevice();
+
+    // A loopback device with m_loopbackFormat, NULL if it cannot be opened in that format
+    ALCdevice* OpenLoopbackDevice();
+
+    // Called by a context once it has left the old device; the last one closes it
+    void FinishMove();
+
+    // Not copyable; the device handle is owned
+    AudioDevice(const AudioDevice&);
+    AudioDevice& operator=(const AudioDevice&);
+
+    friend class AudioContext;
+};
+
+
+// Receives the listener position and a batch of emitter positions from the context, and fills
+// in how occluded each emitter is, from 0 for a clear path to 1 for fully blocked
+typedef std::function<void (const Vec3& listener, const Vec3* pEmitters, float* pOcclusion, size_t count)> OcclusionQuery;
+
+// How Sound::FadeTo and Sound::RampPitch move between the start and end values
+enum FadeCurve
+{
+    FadeLinear,
+    FadeSmooth,         // eases in and out
+    FadeEqualPower,     // sine and cosine, for crossfading two sounds
+    FadeExponential     // even steps in dB, down to -80 dB
+};
+
+// Mix bus handles, for Sound::m_bus and the parent of AudioContext::CreateBus
+enum : unsigned int
+{
+    MasterBus   = 0,    // created with the context; every other bus feeds into it
+    InvalidBus  = ~0u
+};
+
+// A mixing context on a device with its own listener, source pool and buffer registry.
+// A context must only be used from one thread at a time, but separate contexts may be
+// used from separate threads when the device supports ALC_EXT_thread_local_context.
+class AudioContext
+{
+public:
+    AudioContext(AudioDevice* pDevice, const ALCint* attributes = NULL) :
+        m_pDevice(pDevice), m_pAlContext(NULL), m_numBuffers(0), m_numSources(0),
+        m_maxSources(0), m_numStolen(0), m_peakPoolSize(0),
+        m_bufferHits(0), m_bufferMisses(0), m_residentBytes(0), m_hasBufferSamples(false), m_hasLoopPoints(false),
+        m_memoryBudget(0), m_numEvictions(0),
+        m_frameStartCalls(t_numAlCalls), m_alCallsPerFrame(0), m_updateTime(0.0),
+        m_outputLatency(0.0), m_audibleTime(0.0), m_alGetSourcei64vSOFT(NULL), m_zoneSlot(0), m_zonesChanged(false),
+        m_raysPerUpdate(16), m_occlusionCursor(0), m_occlusionFilter(0), m_occludedGain(0.5f), m_occludedGainHF(0.1f),
+        m_occlusionSmoothing(0.1), m_lastOcclusionTime(0.0), m_occlusionRays(0), m_emittersChanged(false),
+        m_busesDirty(false), m_busesChanged(false), m_lastDuckingRule(0), m_lastDuckingTime(0.0),
+        m_autoVelocity(false), m_velocitySmoothing(0.1), m_lastVelocityTime(0.0),
+        m_generation(0), m_deviceGeneration(pDevice->m_deviceGeneration), m_lastSyntheticHandle(0x40000000), m_lastEffectSlotHandle(0), m_restoreBudget(0.002), m_listenerGain(1.f),
+        m_distanceModel(AL_INVERSE_DISTANCE_CLAMPED), m_audibilityThreshold(0.0001f), m_numCulled(0)
+    {
+        // Kept so the context can be recreated on a reopened device
+        m_attributes = pDevice->m_formatAttributes;
+        if (attributes)
+        {
+            for (const ALCint* pAttribute = attributes; *pAttribute; pAttribute += 2)
+            {
+                m_attributes.push_back(pAttribute[0]);
+                m_attributes.push_back(pAttribute[1]);
+            }
+        }
+        if (!m_attributes.empty())
+        {
+            m_attributes.push_back(0);
+        }
+
+        ALfloat listener[] = { 0.0, 0.0, 0.0,  0.0, 0.0, 0.0,  0.0, 0.0, -1.0,  0.0, 1.0, 0.0 };
+        std::copy(listener,     listener + 3,  m_listenerPosition);
+        std::copy(listener + 3, listener + 6,  m_listenerVelocity);
+        std::copy(listener + 6, listener + 12, m_listenerOrientation);
+
+        EFXEAXREVERBPROPERTIES generic = EFX_REVERB_PRESET_GENERIC;
+        m_outsidePreset = generic;
+        m_zonePreset    = generic;
+
+        Bus master = { "Master", MasterBus, 1.f, false, 1.f, 1.f, false };
+        m_buses.push_back(master);
+
+        // A device still opening creates its contexts once it is ready
+        if (pDevice->IsOpen())
+        {
+            CreateAlContext();
+        }
+    }
+
+    // Sounds still alive are detached and do nothing from then on
+    ~AudioContext();
+
+    // Binds this context to the calling thread (or the process without ALC_EXT_thread_local_context)
+    void MakeCurrent()
+    {
+        if (m_pDevice->m_alcSetThreadContext)
+        {
+            if (t_pCurrentContext != this)
+            {
+                OPENAL_CALL(m_pDevice->m_alcSetThreadContext, m_pAlContext);
+            }
+        }
+        else if (g_pCurrentAlContext != m_pAlContext)
+        {
+            alcMakeContextCurrent(m_pAlContext);
+            g_pCurrentAlContext = m_pAlContext;
+        }
+        t_pCurrentContext = this;
+    }
+
+    bool            IsValid() const         { return m_pAlContext != NULL; }
+    AudioDevice*    GetDevice() const       { return m_pDevice; }
+    ALCcontext*     GetAlContext() const    { return m_pAlContext; }
+
+    // The number of buffers and sources alive in this context
+    unsigned int    GetNumBuffers() const   { return m_numBuffers; }
+    unsigned int    GetNumSources() const   { return m_numSources; }
+
+    // Caps the sources the context creates; past the cap the least recently released pooled
+    // source is stopped and reused, or when sounds hold them all, a finished sound's source or
+    // else the longest playing one's. 0 (the default) creates sources until OpenAL refuses.
+    void            SetMaxSources(unsigned int maxSources) { m_maxSources = maxSources; }
+    unsigned int    GetMaxSources() const   { return m_maxSources; }
+
+    // Voices cut short to reuse their source, and the largest the source pool has grown
+    unsigned int    GetNumStolenVoices() const  { return m_numStolen; }
+    size_t          GetPoolSize() const         { return m_sources.size(); }
+    size_t          GetPeakPoolSize() const     { return m_peakPoolSize; }
+
+    // The device timeline that Sound::PlayAt is scheduled against, in seconds
+    double          GetDeviceTime() const   { return m_pDevice->GetTime(); }
+
+    // Seconds between a source starting in the mixer and it being heard, from AL_SOFT_source_latency
+    double          GetOutputLatency() const { return m_outputLatency.load(std::memory_order_relaxed); }
+
+    // Device time of what is audible right now (device time less output latency). Never runs
+    // backwards when the latency estimate changes, and is lock-free to read from any thread.
+    double GetAudibleTime()
+    {
+        double audible  = GetDeviceTime() - GetOutputLatency();
+        double previous = m_audibleTime.load(std::memory_order_relaxed);
+        while (audible > previous && !m_audibleTime.compare_exchange_weak(previous, audible, std::memory_order_relaxed))
+        {
+        }
+        return std::max(audible, previous);
+    }
+
+    // Rolling output and Play()-to-audible latency, sampled from active sources during Update
+    LatencyStats GetLatencyStats() const
+    {
+        LatencyStats stats;
+        stats.minOutput                 = m_outputLatencies.GetMin();
+        stats.avgOutput                 = m_outputLatencies.GetAverage();
+        stats.p99Output                 = m_outputLatencies.GetPercentile(0.99);
+        stats.numOutputSamples          = m_outputLatencies.GetCount();
+        stats.minPlayToAudible          = m_playLatencies.GetMin();
+        stats.avgPlayToAudible          = m_playLatencies.GetAverage();
+        stats.p99PlayToAudible          = m_playLatencies.GetPercentile(0.99);
+        stats.numPlayToAudibleSamples   = m_playLatencies.GetCount();
+        return stats;
+    }
+
+    void ResetLatencyStats()
+    {
+        m_outputLatencies.Clear();
+        m_playLatencies.Clear();
+    }
+
+    // Voice, buffer and frame cost counters for a performance HUD; costs no AL calls
+    AudioStats GetStats() const
+    {
+        AudioStats stats;
+        stats.activeVoices      = static_cast<unsigned int>(m_voices.size());
+        stats.virtualVoices     = static_cast<unsigned int>(m_scheduled.size() + m_virtualPlays.size());
+        stats.culledPlays       = m_numCulled;
+        stats.freeVoices        = m_numSources > stats.activeVoices ? m_numSources - stats.activeVoices : 0;
+        stats.stolenVoices      = m_numStolen;
+        stats.numSources        = m_numSources;
+        stats.numBuffers        = m_numBuffers;
+        stats.bufferHits        = m_bufferHits;
+        stats.bufferMisses      = m_bufferMisses;
+        stats.residentBytes     = m_residentBytes;
+        stats.bufferEvictions   = m_numEvictions;
+        stats.alCallsPerFrame   = m_alCallsPerFrame;
+        stats.occlusionRays     = m_occlusionRays;
+        stats.numEmitters       = static_cast<unsigned int>(m_emitters.size());
+        stats.emittersInRange   = static_cast<unsigned int>(m_emittersInRange.size());
+        stats.updateTime        = m_updateTime;
+        stats.avgUpdateTime     = m_updateTimes.GetAverage();
+        stats.maxUpdateTime     = m_updateTimes.GetMax();
+        return stats;
+    }
+
+    // Starts scheduled sounds that have come due and samples active sources; call once per frame
+    void Update();
+
+    void SchedulePlay(Sound* pSound, double deviceTime, bool overlap);
+    void QueuePlay(Sound* pSound, bool overlap)
+    {
+        ScheduledPlay play = { pSound, GetDeviceTime(), overlap };
+        m_queuedPlays.push_back(play);
+    }
+    void Cull(Sound* pSound, bool overlap, double skipSeconds);
+    void CancelScheduled(Sound* pSound);
+
+    // Forgets the plays queued while the device was opening; returns how many there were
+    size_t DropQueuedPlays()
+    {
+        size_t count = m_queuedPlays.size();
+        m_queuedPlays.clear();
+        return count;
+    }
+
+    // Drops every reference the context holds to a sound that is going away
+    void ForgetSound(Sound* pSound);
+
+    // Listener state is also kept here so it can be restored on a reopened device
+    void SetListenerPosition(const Vec3& position)
+    {
+        MakeCurrent();
+        ALfloat ListenerPos[] = { position.x, position.y, position.z };
+        std::copy(ListenerPos, ListenerPos + 3, m_listenerPosition);
+        alListenerfv(AL_POSITION,    ListenerPos);
+    }
+
+    void SetListenerVelocity(const Vec3& velocity)
+    {
+        MakeCurrent();
+        ALfloat ListenerVel[] = { velocity.x, velocity.y, velocity.z };
+        std::copy(ListenerVel, ListenerVel + 3, m_listenerVelocity);
+        alListenerfv(AL_VELOCITY,    ListenerVel);
+    }
+
+    void SetListenerOrientation(const Vec3& forward, const Vec3& up)
+    {
+        MakeCurrent();
+        ALfloat ListenerOri[] = { forward.x, forward.y, forward.z, up.x, up.y, up.z };
+        std::copy(ListenerOri, ListenerOri + 6, m_listenerOrientation);
+        alListenerfv(AL_ORIENTATION, ListenerOri);
+    }
+
+    void SetListenerGain(const float& gain)
+    {
+        MakeCurrent();
+        ALfloat listenerGain = gain;
+        m_listenerGain = listenerGain;
+        alListenerf(AL_GAIN, listenerGain);
+    }
+
+    void SetDistanceModel(ALenum model)
+    {
+        MakeCurrent();
+        m_distanceModel = model;
+        alDistanceModel(model);
+    }
+
+    ALenum GetDistanceModel() const { return m_distanceModel; }
+
+    // Plays quieter than this gain at the listener, after distance attenuation (worked out on
+    // the CPU with the context's distance model) but before the listener gain, get no source.
+    // Looping sounds wait as virtual voices and start, in step, once they come within range;
+    // one-shots are dropped. A culled play that does not overlap still stops what the sound
+    // was playing and replaces its waiting voice. 0 turns culling off; the default, 0.0001,
+    // is -80 dB.
+    void    SetAudibilityThreshold(float gain)  { m_audibilityThreshold = gain; }
+    float   GetAudibilityThreshold() const      { return m_audibilityThreshold; }
+
+    bool    IsAudible(const Sound& sound) const;
+
+    ALuint  CreateBuffer(const WavSourceRef& source);
+    void    DestroyBuffer(ALuint alBuffer);
+
+    // Any source WavSourceTraits knows how to read, such as a ci::DataSourceRef with OpenAL.h
+    template<typename Source>
+    ALuint CreateBuffer(const Source& source)
+    {
+        return CreateBuffer(WavSourceTraits<Source>::Make(source));
+    }
+
+    // Loads a .wav the caller keeps; the data is only read during the call, so the buffer
+    // cannot be rebuilt if the device is reopened
+    ALuint  CreateBuffer(const void* pData, size_t size);
+
+    // Returns a handle without reading the source; the buffer is loaded the first time it is
+    // played, prefetched or prewarmed. Errors in the .wav are reported then.
+    ALuint CreateDeferredBuffer(const WavSourceRef& source)
+    {
+        if (!source)
+        {
+            ReportError("No wav source");
+            return 0;
+        }
+        return AddBufferRecord(0, 0, source, false);
+    }
+
+    template<typename Source>
+    ALuint CreateDeferredBuffer(const Source& source)
+    {
+        return CreateDeferredBuffer(WavSourceTraits<Source>::Make(source));
+    }
+
+    // Hands ownership of a buffer to the context; it is deleted along with the context
+    void RegisterBuffer(ALuint alBuffer)
+    {
+        if (alBuffer)
+        {
+            auto it = m_bufferRecords.find(alBuffer);
+            if (it != m_bufferRecords.end())
+            {
+                it->second.owned = true;
+            }
+            else
+            {
+                // Buffers created outside the context cannot be restored after a reopen or evicted
+                AddBufferRecord(alBuffer, alBuffer, WavSourceRef(), true);
+            }
+        }
+    }
+
+    // The current AL name of a buffer handle returned by CreateBuffer. Names change when the
+    // device is reopened or the buffer is evicted; a buffer that is not resident is reloaded
+    // on the spot.
+    ALuint ResolveBuffer(ALuint alBuffer)
+    {
+        bool loaded;
+        return ResolveBuffer(alBuffer, loaded);
+    }
+
+    // Bytes of PCM the context keeps resident. Past the budget, the least recently used buffers
+    // that no voice is playing are evicted and reloaded from their source when next played.
+    // Buffers without a source (raw data or registered names) are never evicted. 0 is no limit.
+    void SetMemoryBudget(size_t bytes)
+    {
+        m_memoryBudget = bytes;
+        EnforceMemoryBudget(0);
+    }
+
+    size_t GetMemoryBudget() const { return m_memoryBudget; }
+
+    // Restores an evicted buffer during the coming updates, within the restore budget, so the
+    // next play does not have to reload it
+    void Prefetch(ALuint alBuffer)
+    {
+        auto it = m_bufferRecords.find(alBuffer);
+        if (it != m_bufferRecords.end() && it->second.name == 0)
+        {
+            m_pendingBuffers.push_back(alBuffer);
+        }
+    }
+
+    // Loads any of the buffers that are not resident now, so their first play does not have
+    // to. Pinned buffers are not evicted by the memory budget until they are unpinned.
+    void Prewarm(const std::vector<ALuint>& buffers, bool pin = false)
+    {
+        MakeCurrent();
+        for (ALuint handle : buffers)
+        {
+            auto it = m_bufferRecords.find(handle);
+            if (it == m_bufferRecords.end())
+            {
+                continue;
+            }
+
+            m_lru.splice(m_lru.end(), m_lru, it->second.lru);
+            if (it->second.name == 0 && IsValid())
+            {
+                RestoreBuffer(it->second);
+            }
+            else if (it->second.name == 0 && it->second.source)
+            {
+                // The device is still opening; read the file now and upload it once it is ready
+                it->second.source->Load();
+                m_pendingBuffers.push_back(handle);
+            }
+            it->second.pinned = it->second.pinned || pin;
+        }
+        EnforceMemoryBudget(0);
+    }
+
+    void Unpin(const std::vector<ALuint>& buffers)
+    {
+        for (ALuint handle : buffers)
+        {
+            auto it = m_bufferRecords.find(handle);
+            if (it != m_bufferRecords.end())
+            {
+                it->second.pinned = false;
+            }
+        }
+        EnforceMemoryBudget(0);
+    }
+
+    // Makes looping sounds play a buffer through once and then repeat [startFrame, endFrame),
+    // so music with an intro plays from one static source. .wav files with a smpl chunk get
+    // the points of their first loop; 0, 0 loops the whole buffer again. Needs
+    // AL_SOFT_loop_points, and no voice may be playing the buffer.
+    void SetLoopPoints(ALuint alBuffer, ALint startFrame, ALint endFrame);
+
+    // The loop points in effect for a buffer handle; false if it loops end to end
+    bool GetLoopPoints(ALuint alBuffer, ALint& startFrame, ALint& endFrame) const
+    {
+        auto it = m_bufferRecords.find(alBuffer);
+        if (!m_hasLoopPoints || it == m_bufferRecords.end() || it->second.loopEnd <= it->second.loopStart)
+        {
+            startFrame = 0;
+            endFrame   = 0;
+            return false;
+        }
+        startFrame = it->second.loopStart;
+        endFrame   = it->second.loopEnd;
+        return true;
+    }
+
+    // Seconds per update spent restoring buffers not needed by any voice after a reopen
+    void SetRestoreBudget(double seconds) { m_restoreBudget = seconds; }
+
+    // A shared auxiliary effect slot running the reverb of an EFX_REVERB_PRESET_* preset from
+    // efx-presets.h. Any number of sounds send into one slot (Sound::m_effectSlot), so a few
+    // slots serve every voice. The handle stays valid if the device is reopened; 0 if the
+    // device has no EFX.
+    ALuint  CreateReverbSlot(const EFXEAXREVERBPROPERTIES& preset, float gain = 1.f);
+    void    SetReverbPreset(ALuint slot, const EFXEAXREVERBPROPERTIES& preset);
+    void    SetEffectSlotGain(ALuint slot, float gain);
+    void    DestroyEffectSlot(ALuint slot);
+
+    bool    HasEffects() const      { return m_efx.IsSupported(); }
+
+    // Reverb zones drive one shared slot from the listener position. Each update blends the
+    // presets of the zones around the listener, and the outside preset where they do not
+    // cover it, and writes the slot only when the result has changed.
+    void SetReverbZoneSlot(ALuint slot, const EFXEAXREVERBPROPERTIES& outside)
+    {
+        m_zoneSlot      = slot;
+        m_outsidePreset = outside;
+        m_zonesChanged  = true;
+        auto it = m_effectSlots.find(slot);
+        if (it != m_effectSlots.end())
+        {
+            m_zonePreset = it->second.preset;
+        }
+    }
+
+    unsigned int AddReverbZone(const ReverbZone& zone)
+    {
+        m_zonesChanged = true;
+        return m_reverbZones.Add(zone);
+    }
+
+    void RemoveReverbZone(unsigned int zone)
+    {
+        m_zonesChanged = true;
+        m_reverbZones.Remove(zone);
+    }
+
+    // Edge length of the grid cells zones are indexed by; about the size of a typical zone
+    void SetReverbZoneCellSize(float cellSize) { m_reverbZones.SetCellSize(cellSize); }
+
+    // Occlusion muffles voices through a low-pass filter on their direct path. Each update
+    // asks the query about at most raysPerUpdate voices, newly started ones first and then
+    // the rest in turn, so the cost stays fixed however many voices play. An empty query
+    // turns occlusion off. Needs ALC_EXT_EFX.
+    void SetOcclusionQuery(const OcclusionQuery& query, unsigned int raysPerUpdate = 16)
+    {
+        m_occlusionQuery = query;
+        m_raysPerUpdate  = raysPerUpdate;
+    }
+
+    // Gain and high frequency gain of a fully occluded voice
+    void SetOcclusionFilter(float occludedGain, float occludedGainHF)
+    {
+        m_occludedGain   = occludedGain;
+        m_occludedGainHF = occludedGainHF;
+    }
+
+    // Seconds for a voice's filter to move most of the way (1 - 1/e) to a new query result
+    void SetOcclusionSmoothing(double seconds) { m_occlusionSmoothing = seconds; }
+
+    // Emitters are sounds placed in the world, such as torches or rivers, that play while the
+    // listener is within their radius and give up their source when it leaves. They are kept
+    // in a grid, so each update only looks at the emitters around the listener. Looping
+    // emitters stay in step as if they had played all along. A sound is one emitter; adding
+    // it again changes its radius.
+    unsigned int AddEmitter(Sound* pSound, float radius);
+    void RemoveEmitter(unsigned int emitter);
+
+    // Moves the emitter's sound, and its source if it is playing
+    void MoveEmitter(unsigned int emitter, const Vec3& position);
+    void SetEmitterRadius(unsigned int emitter, float radius);
+
+    // Edge length of the grid cells emitters are indexed by; about a typical emitter radius
+    void SetEmitterCellSize(float cellSize)
+    {
+        m_emitterGrid.SetCellSize(cellSize);
+        m_emittersChanged = true;
+    }
+
+    // Mix buses form a tree under the master bus, e.g. Master > SFX > Weapons. A sound plays at
+    // its m_gain times the volume of its bus and of every bus above it, zero if any of them
+    // is muted. Volume and mute changes are resolved for the whole tree in one pass at the
+    // next update, and only voices on buses whose gain changed are rewritten.
+    unsigned int CreateBus(const std::string& name, unsigned int parent = MasterBus)
+    {
+        if (parent >= m_buses.size())
+        {
+            ReportError("No parent bus");
+            return InvalidBus;
+        }
+
+        // Parents always come before their children, so one pass in order resolves the tree
+        Bus bus = { name, parent, 1.f, false, 1.f, m_buses[parent].gain, false };
+        m_buses.push_back(bus);
+        return static_cast<unsigned int>(m_buses.size() - 1);
+    }
+
+    // InvalidBus if there is no bus of that name
+    unsigned int FindBus(const std::string& name) const
+    {
+        for (size_t i = 0; i < m_buses.size(); ++i)
+        {
+            if (m_buses[i].name == name)
+            {
+                return static_cast<unsigned int>(i);
+            }
+        }
+        return InvalidBus;
+    }
+
+    void SetBusVolume(unsigned int bus, float volume)
+    {
+        if (bus < m_buses.size() && m_buses[bus].volume != volume)
+        {
+            m_buses[bus].volume = volume;
+            m_busesDirty        = true;
+        }
+    }
+
+    void SetBusMuted(unsigned int bus, bool muted)
+    {
+        if (bus < m_buses.size() && m_buses[bus].muted != muted)
+        {
+            m_buses[bus].muted = muted;
+            m_busesDirty       = true;
+        }
+    }
+
+    float   GetBusVolume(unsigned int bus) const    { return bus < m_buses.size() ? m_buses[bus].volume : 0.f; }
+    bool    IsBusMuted(unsigned int bus) const      { return bus < m_buses.size() && m_buses[bus].muted; }
+
+    // Ducks the target bus by attenuation dB while anything plays on the trigger bus or a bus
+    // below it, e.g. Music under VO. The duck moves in over attack seconds and back out over
+    // release seconds. Rules are evaluated once per update from the voices the update already
+    // polls, and act through the bus gains, so they cost no extra AL queries.
+    unsigned int AddDucking(unsigned int trigger, unsigned int target, float attenuation, double attack = 0.05, double release = 0.5)
+    {
+        if (trigger >= m_buses.size() || target >= m_buses.size())
+        {
+            ReportError("No bus to duck");
+            return 0;
+        }
+        DuckingRule rule = { trigger, target, std::pow(10.f, -std::fabs(attenuation) / 20.f), attack, release, 0.f };
+        m_duckingRules[++m_lastDuckingRule] = rule;
+        return m_lastDuckingRule;
+    }
+
+    void RemoveDucking(unsigned int rule)
+    {
+        if (m_duckingRules.erase(rule))
+        {
+            m_busesDirty = true;
+            for (Bus& bus : m_buses)
+            {
+                bus.duck = 1.f;
+            }
+            UpdateDucking(m_lastDuckingTime);
+        }
+    }
+
+    // The gain a bus applies after its parents' volumes, mutes and ducking
+    float GetBusGain(unsigned int bus)
+    {
+        ResolveBuses();
+        return bus < m_buses.size() ? m_buses[bus].gain : 1.f;
+    }
+
+    // Works out the listener's velocity, and the velocity of every playing sound, from how far
+    // they moved since the last update, so Doppler follows the positions without setting
+    // m_velocity or SetListenerVelocity by hand. Velocities are smoothed over about smoothing
+    // seconds, and the playing voices of sounds also follow their m_position.
+    void SetAutoVelocity(bool enabled, double smoothing = 0.1)
+    {
+        m_autoVelocity      = enabled;
+        m_velocitySmoothing = smoothing;
+        m_lastVelocityTime  = GetDeviceTime();
+        m_lastListenerPosition = Vec3(m_listenerPosition[0], m_listenerPosition[1], m_listenerPosition[2]);
+        for (Voice& voice : m_voices)
+        {
+            voice.tracked = false;
+        }
+    }
+
+    // Appends the sounds of the emitters whose radius reaches a point
+    void QueryEmitters(const Vec3& point, std::vector<Sound*>& sounds) const
+    {
+        m_emittersFound.clear();
+        m_emitterGrid.Query(point, m_emittersFound);
+        for (unsigned int id : m_emittersFound)
+        {
+            sounds.push_back(m_emitters.find(id)->second.pSound);
+        }
+    }
+
+    // Reuses a stopped pooled source if possible, otherwise creates a new source
+    ALuint AcquireSource()
+    {
+        ALuint alSource = 0;
+        try
+        {
+            MakeCurrent();
+            if (HasAlError())
+            {
+                throw ("Error occurred before getting source");
+            }
+
+            bool sourceFound = false;
+            int i = 0;
+
+            for (ALuint source : m_sources)
+            {
+                ALint state;
+                alGetSourcei(source, AL_SOURCE_STATE, &state);
+                if (state == AL_INITIAL || state == AL_STOPPED)
+                {
+                    alSource = source;
+                    sourceFound = true;
+                    break;
+                }
+                i++;
+            }
+
+            if (sourceFound)
+            {
+                m_sources.erase(m_sources.begin() + i);
+            }
+            else if (m_maxSources && m_numSources >= m_maxSources && !m_sources.empty())
+            {
+                // Steal the voice that has been playing the longest since it was released
+                alSource = m_sources.front();
+                m_sources.pop_front();
+                alSourceStop(alSource);
+                ++m_numStolen;
+            }
+            else if (m_maxSources && m_numSources >= m_maxSources)
+            {
+                // Every source is held by a sound; take one from a sound instead
+                alSource = StealSoundSource();
+                if (alSource == 0)
+                {
+                    throw ("Source limit reached");
+                }
+            }
+            else
+            {
+                alSource = CreateSource();
+            }
+        }
+        catch(const char* error)
+        {
+            ReportError(error);
+            alSource = 0;
+        }
+        return alSource;
+    }
+
+    // Takes the source of a sound that has finished playing, or else of the voice that has
+    // played longest, away from its sound; 0 if no sound holds one
+    ALuint StealSoundSource();
+
+    // Returns a source to the pool; it may still be playing and is reused once it stops
+    void ReleaseSource(ALuint alSource)
+    {
+        if (alSource)
+        {
+            m_sources.push_back(alSource);
+            m_peakPoolSize = std::max(m_peakPoolSize, m_sources.size());
+        }
+    }
+
+private:
+    AudioDevice*        m_pDevice;
+    ALCcontext*         m_pAlContext;
+
+    // A list of sources unassociated with sounds from least to most recently used
+    std::deque<ALuint>  m_sources;
+
+    // Sounds created in this context and not yet destroyed
+    std::unordered_set<Sound*> m_sounds;
+
+    // Every buffer created or registered in this context, by the handle given out for it
+    struct BufferRecord
+    {
+        ALuint              name;       // current AL name, 0 until restored after a reopen
+        ALint               bytes;      // resident PCM size while the name is valid
+        WavSourceRef        source;     // reparsed to restore the buffer on a new device
+        bool                owned;      // deleted along with the context
+        bool                pinned;     // never evicted, see Prewarm
+        ALint               loopStart;  // loop points in sample frames, from the .wav unless
+        ALint               loopEnd;    // loopSet; both 0 to loop the whole buffer
+        bool                loopSet;    // set with SetLoopPoints, which overrides the .wav
+        std::list<ALuint>::iterator lru;    // position in m_lru
+    };
+    std::unordered_map<ALuint, BufferRecord> m_bufferRecords;
+
+    // Buffer handles from least to most recently used
+    std::list<ALuint>   m_lru;
+
+    // The buffer handle attached to each source, so a source already holding the right buffer
+    // is not rebound and an evicted buffer can be detached from idle sources
+    std::unordered_map<ALuint, ALuint> m_sourceBuffers;
+
+    unsigned int        m_numBuffers;
+    unsigned int        m_numSources;
+    unsigned int        m_maxSources;
+    unsigned int        m_numStolen;
+    size_t              m_peakPoolSize;
+
+    unsigned int        m_bufferHits;
+    unsigned int        m_bufferMisses;
+    size_t              m_residentBytes;
+    bool                m_hasBufferSamples;
+    bool                m_hasLoopPoints;
+    size_t              m_memoryBudget;
+    unsigned int        m_numEvictions;
+
+    // t_numAlCalls when the last update started
+    unsigned int        m_frameStartCalls;
+    unsigned int        m_alCallsPerFrame;
+    double              m_updateTime;
+    RollingStats        m_updateTimes;
+
+    // Sounds waiting for their device time to come due
+    struct ScheduledPlay
+    {
+        Sound*  pSound;
+        double  deviceTime;
+        bool    overlap;
+    };
+    std::vector<ScheduledPlay> m_scheduled;
+
+    // Plays made while the device was opening, started once it is ready; deviceTime is when
+    // Play was called
+    std::vector<ScheduledPlay> m_queuedPlays;
+
+    // Looping sounds culled as inaudible; deviceTime is when they would have started
+    std::vector<ScheduledPlay> m_virtualPlays;
+
+    // Sources started by sounds that have not yet been seen stopped
+    struct Voice
+    {
+        ALuint  source;
+        Sound*  pSound;         // NULL once the sound is destroyed
+        double  playTime;       // device time Play was called
+        ALint   startOffset;    // sample frame playback was started from
+        bool    heard;          // Play()-to-audible has been measured
+        ALint   frequency;      // of the buffer being played
+        ALfloat pitch;
+        double  offset;         // last sample offset seen and the device time it was seen
+        double  offsetTime;
+        bool    paused;
+        float   occlusion;          // smoothed toward occlusionTarget each update
+        float   occlusionTarget;    // last query result
+        float   occlusionWritten;   // level the source's direct filter was last set to
+        bool    occlusionQueried;
+        unsigned int bus;       // of the sound when it was started
+        float   gain;           // the sound's own gain, before its bus
+        bool    tracked;        // position and velocity below are set, see SetAutoVelocity
+        Vec3    position;       // last written to the source
+        Vec3    velocity;
+    };
+    std::vector<Voice>  m_voices;
+
+    std::atomic<double> m_outputLatency;
+    std::atomic<double> m_audibleTime;
+    RollingStats        m_outputLatencies;
+    RollingStats        m_playLatencies;
+
+    LPALGETSOURCEI64VSOFT m_alGetSourcei64vSOFT;
+    EfxFunctions        m_efx;
+
+    // Shared effect slots by the handle given out for them
+    struct EffectSlotRecord
+    {
+        ALuint                  slot;       // current AL names, 0 until created on the device
+        ALuint                  effect;
+        EFXEAXREVERBPROPERTIES  preset;
+        ALfloat                 gain;
+    };
+    std::unordered_map<ALuint, EffectSlotRecord> m_effectSlots;
+
+    // The effect slot handle each source sends into, so sends are only set when they change
+    std::unordered_map<ALuint, ALuint> m_sourceSlots;
+
+    ReverbZoneSet           m_reverbZones;
+    ALuint                  m_zoneSlot;
+    EFXEAXREVERBPROPERTIES  m_outsidePreset;
+    EFXEAXREVERBPROPERTIES  m_zonePreset;       // last written to m_zoneSlot
+    Vec3                    m_zoneListener;     // listener position m_zonePreset was evaluated at
+    bool                    m_zonesChanged;
+
+    OcclusionQuery      m_occlusionQuery;
+    unsigned int        m_raysPerUpdate;
+    size_t              m_occlusionCursor;  // next voice in the round robin
+    ALuint              m_occlusionFilter;  // scratch filter; sources copy it when it is attached
+    float               m_occludedGain;
+    float               m_occludedGainHF;
+    double              m_occlusionSmoothing;
+    double              m_lastOcclusionTime;
+    unsigned int        m_occlusionRays;    // queried in the last update
+    std::vector<size_t> m_occlusionVoices;  // batch being queried, reused between updates
+    std::vector<Vec3>   m_occlusionEmitters;
+    std::vector<float>  m_occlusionResults;
+
+    struct EmitterRecord
+    {
+        Sound*  pSound;
+        double  startTime;      // device time a looping emitter's loop is kept in step with
+    };
+    EmitterGrid         m_emitterGrid;
+    std::unordered_map<unsigned int, EmitterRecord> m_emitters;
+    std::unordered_map<Sound*, unsigned int>        m_soundEmitters;
+    std::vector<unsigned int>   m_emittersInRange;  // sorted, as of the last update
+    mutable std::vector<unsigned int> m_emittersFound;  // reused between updates
+    Vec3                m_emitterListener;  // listener position m_emittersInRange was found at
+    bool                m_emittersChanged;
+
+    // Mix buses by handle, each after its parent
+    struct Bus
+    {
+        std::string     name;
+        unsigned int    parent;
+        float           volume;
+        bool            muted;
+        float           duck;       // product of the ducking rules acting on the bus
+        float           gain;       // resolved through the parents
+        bool            changed;    // gain changed since voices were last updated
+    };
+    std::vector<Bus>    m_buses;
+    bool                m_busesDirty;       // a volume or mute changed since the last resolve
+    bool                m_busesChanged;     // some bus has changed set
+
+    // Gain fades and pitch ramps on sounds; the sound's current voice follows along
+    struct Fade
+    {
+        Sound*      pSound;
+        bool        pitch;      // a pitch ramp rather than a gain fade
+        FadeCurve   curve;
+        bool        stopAtEnd;
+        float       from;
+        float       to;
+        float       value;      // as of the last update
+        double      startTime;
+        double      duration;
+    };
+    std::vector<Fade>   m_fades;
+
+    struct DuckingRule
+    {
+        unsigned int    trigger;
+        unsigned int    target;
+        float           duckedGain;
+        double          attack;
+        double          release;
+        float           amount;     // 0 untouched to 1 fully ducked
+    };
+    std::unordered_map<unsigned int, DuckingRule> m_duckingRules;
+    unsigned int        m_lastDuckingRule;
+    std::vector<unsigned int> m_busVoices;  // playing voices on each bus and the buses below it
+    double              m_lastDuckingTime;
+
+    bool                m_autoVelocity;
+    double              m_velocitySmoothing;
+    double              m_lastVelocityTime;
+    Vec3                m_lastListenerPosition;
+
+    // Positions and velocities of the tracked voices, one array per component, so the
+    // velocities of every voice are worked out in one loop
+    struct MotionBatch
+    {
+        std::vector<size_t> voices;
+        std::vector<float>  x, y, z;        // position now
+        std::vector<float>  lx, ly, lz;     // position at the last update
+        std::vector<float>  vx, vy, vz;     // smoothed velocity
+
+        void Clear()
+        {
+            voices.clear();
+            x.clear();  y.clear();  z.clear();
+            lx.clear(); ly.clear(); lz.clear();
+            vx.clear(); vy.clear(); vz.clear();
+        }
+    };
+    MotionBatch         m_motion;
+
+    // Incremented whenever the context is recreated on a reopened device; sounds holding a
+    // source from an older generation drop it
+    unsigned int        m_generation;
+    unsigned int        m_deviceGeneration;     // of the device reopen this context is on
+    ALuint              m_lastSyntheticHandle;
+    ALuint              m_lastEffectSlotHandle;
+    std::vector<ALCint> m_attributes;
+
+    // Voices captured from the lost device and buffers still to be restored on the new one
+    struct RestoreVoice
+    {
+        Voice   voice;
+        ALuint  buffer;         // handle
+        ALfloat gain;
+        ALfloat pitch;
+        ALfloat position[3];
+        ALfloat velocity[3];
+        ALint   looping;
+        ALint   relative;
+        ALuint  effectSlot;     // handle
+    };
+    std::vector<RestoreVoice> m_restoreVoices;
+    std::deque<ALuint>  m_pendingBuffers;
+    double              m_restoreBudget;
+
+    ALfloat             m_listenerPosition[3];
+    ALfloat             m_listenerVelocity[3];
+    ALfloat             m_listenerOrientation[6];
+    ALfloat             m_listenerGain;
+    ALenum              m_distanceModel;
+    float               m_audibilityThreshold;
+    unsigned int        m_numCulled;
+
+    friend class AudioDevice;
+
+    void CreateAlContext()
+    {
+        try
+        {
+            m_pAlContext = alcCreateContext(m_pDevice->GetAlDevice(), m_attributes.empty() ? NULL : &m_attributes[0]);
+            if (m_pAlContext == NULL)
+            {
+                throw ("Error occurred creating AL context");
+            }
+
+            // Force the binding; a reopened context may reuse the old handle value
+            t_pCurrentContext   = NULL;
+            g_pCurrentAlContext = NULL;
+            MakeCurrent();
+            if (HasAlError())
+            {
+                throw ("Error occurred initializing OpenAL");
+            }
+
+            // Source latency gives the delay between the mixer offset and what is audible
+            m_alGetSourcei64vSOFT = NULL;
+            if (alIsExtensionPresent("AL_SOFT_source_latency"))
+            {
+                m_alGetSourcei64vSOFT = reinterpret_cast<LPALGETSOURCEI64VSOFT>(alGetProcAddress("alGetSourcei64vSOFT"));
+
+                // An idle source reports the device latency too, so the first scheduled play is
+                // placed on the timeline as well as those that follow a measured voice
+                ALuint probe = 0;
+                alGenSources(1, &probe);
+                if (probe)
+                {
+                    ALint64SOFT offsetLatency[2] = { 0, 0 };
+                    OPENAL_CALL(m_alGetSourcei64vSOFT, probe, AL_SAMPLE_OFFSET_LATENCY_SOFT, offsetLatency);
+                    m_outputLatency = offsetLatency[1] * 1.0e-9;
+                    alDeleteSources(1, &probe);
+                }
+            }
+
+            // Buffer samples adds AL_BYTE_LENGTH_SOFT, the size of the buffer as stored
+            m_hasBufferSamples = alIsExtensionPresent("AL_SOFT_buffer_samples") != AL_FALSE;
+
+            // Loop points let one static source play an intro and then repeat the rest
+            m_hasLoopPoints = alIsExtensionPresent("AL_SOFT_loop_points") != AL_FALSE;
+
+            m_efx.Load(m_pDevice->m_pAlDevice);
+        }
+        catch(const char* error)
+        {
+            ReportError(error);
+            return;
+        }
+
+        alListenerfv(AL_POSITION,    m_listenerPosition);
+        alListenerfv(AL_VELOCITY,    m_listenerVelocity);
+        alListenerfv(AL_ORIENTATION, m_listenerOrientation);
+        alListenerf (AL_GAIN,        m_listenerGain);
+        alDistanceModel(m_distanceModel);
+
+        // Slots created before the device was open, or lost with the previous device
+        if (m_efx.IsSupported())
+        {
+            for (auto& entry : m_effectSlots)
+            {
+                CreateEffectSlot(entry.second);
+            }
+        }
+    }
+
+    void DestroyAlContext()
+    {
+        MakeCurrent();
+        if (m_pDevice->m_alcSetThreadContext)
+        {
+            OPENAL_CALL(m_pDevice->m_alcSetThreadContext, NULL);
+        }
+        if (g_pCurrentAlContext == m_pAlContext)
+        {
+            alcMakeContextCurrent(NULL);
+            g_pCurrentAlContext = NULL;
+        }
+        if (t_pCurrentContext == this)
+        {
+            t_pCurrentContext = NULL;
+        }
+        alcDestroyContext(m_pAlContext);
+        m_pAlContext = NULL;
+    }
+
+    ALuint UploadBuffer(const WavData& wav);
+    ALint GetBufferBytes(ALuint alBuffer);
+
+    // The work of Update, without the frame accounting
+    void Tick();
+    void RestoreBuffer(BufferRecord& record);
+    ALuint AddBufferRecord(ALuint handle, ALuint alBuffer, const WavSourceRef& source, bool owned, ALint loopStart = 0, ALint loopEnd = 0);
+    void EnforceMemoryBudget(ALuint keepHandle);
+    void DetachBuffer(ALuint handle);
+
+    // Sets loaded if the buffer had to be reloaded
+    ALuint ResolveBuffer(ALuint alBuffer, bool& loaded)
+    {
+        loaded = false;
+        auto it = m_bufferRecords.find(alBuffer);
+        if (it == m_bufferRecords.end())
+        {
+            return alBuffer;
+        }
+
+        // Most recently used at the back
+        m_lru.splice(m_lru.end(), m_lru, it->second.lru);
+        if (it->second.name == 0 && IsValid())
+        {
+            loaded = true;
+            RestoreBuffer(it->second);
+            EnforceMemoryBudget(alBuffer);
+        }
+        return it->second.name;
+    }
+
+    // Attaches the current name of a buffer handle to a source unless it is already attached;
+    // returns the name, 0 if the buffer could not be loaded. Called once per play, so it is
+    // what the buffer hit and miss counts count.
+    ALuint BindBuffer(ALuint alSource, ALuint handle)
+    {
+        bool loaded;
+        ALuint name = ResolveBuffer(handle, loaded);
+        if (loaded)
+        {
+            ++m_bufferMisses;
+        }
+        else
+        {
+            ++m_bufferHits;
+        }
+        auto it = m_sourceBuffers.find(alSource);
+        if (name && (it == m_sourceBuffers.end() || it->second != handle))
+        {
+            alSourcei(alSource, AL_BUFFER, name);
+            m_sourceBuffers[alSource] = handle;
+        }
+        return name;
+    }
+    void SuspendForReopen(double deviceTime);
+    void ResumeAfterReopen();
+    void CreateEffectSlot(EffectSlotRecord& record);
+    void DeleteEffectSlot(EffectSlotRecord& record);
+    void UpdateReverbZones();
+    void UpdateOcclusion(double now);
+    void ApplyOcclusion(ALuint alSource, float occlusion);
+    void UpdateEmitters(double now);
+    void ResolveBuses();
+    void AddFade(Sound* pSound, bool pitch, float to, double seconds, FadeCurve curve, bool stopAtEnd);
+    void UpdateFades(double now);
+    void UpdateVelocities(double now);
+    void UpdateDucking(double now);
+    void UpdateBuses();
+
+    // Points a source's first auxiliary send at an effect slot handle, 0 for none, unless it
+    // already sends there. Devices with no auxiliary sends play dry.
+    void BindEffectSlot(ALuint alSource, ALuint handle)
+    {
+        if (!m_efx.IsSupported() || m_efx.maxSends < 1)
+        {
+            return;
+        }
+
+        auto it = m_sourceSlots.find(alSource);
+        ALuint current = it != m_sourceSlots.end() ? it->second : 0;
+        if (current != handle)
+        {
+            auto slot = m_effectSlots.find(handle);
+            ALuint name = slot != m_effectSlots.end() ? slot->second.slot : AL_EFFECTSLOT_NULL;
+            alSource3i(alSource, AL_AUXILIARY_SEND_FILTER, name, 0, AL_FILTER_NULL);
+            m_sourceSlots[alSource] = handle;
+        }
+    }
+
+    void AddVoice(ALuint alSource, Sound* pSound, ALint startOffset, ALint frequency, ALfloat pitch, unsigned int bus, float gain)
+    {
+        double now = GetDeviceTime();
+        Voice voice = { alSource, pSound, now, startOffset, false, frequency, pitch, static_cast<double>(startOffset), now, false, 0.f, 0.f, 0.f, false,
+                        bus < m_buses.size() ? bus : MasterBus, gain, false, Vec3(), Vec3() };
+        for (Voice& existing : m_voices)
+        {
+            if (existing.source == alSource)
+            {
+                // The source still has whatever filter the voice before left on it
+                voice.occlusionWritten = existing.occlusionWritten;
+                existing = voice;
+                return;
+            }
+        }
+        m_voices.push_back(voice);
+    }
+
+    friend class Sound;
+
+    // Not copyable; the context handle and pooled names are owned
+    AudioContext(const AudioContext&);
+    AudioContext& operator=(const AudioContext&);
+
+    ALuint CreateSource()
+    {
+        ALuint alSource;
+        try
+        {
+            if (HasAlError())
+            {
+                throw ("Error occurred before creating source");
+            }
+
+            // Create our openAL source and check for success
+            alGenSources(1, &alSource);
+            if (HasAlError())
+            {
+                throw ("alGenSources threw an error");
+            }
+            ++m_numSources;
+        }
+        catch(const char* error)
+        {
+            ReportError(error);
+            alSource = 0;
+        }
+        return alSource;
+    }
+};
+
+inline AudioContext* AudioDevice::CreateContext(const ALCint* attributes)
+{
+    if (!IsOpen() && !IsOpening())
+    {
+        return NULL;
+    }
+
+    AudioContext* pContext = new AudioContext(this, attributes);
+    if (!pContext->IsValid() && !IsOpening())
+    {
+        delete pContext;
+        return NULL;
+    }
+    m_contexts.push_back(pContext);
+    return pContext;
+}
+
+inline void AudioDevice::DestroyContext(AudioContext* pContext)
+{
+    auto it = std::find(m_contexts.begin(), m_contexts.end(), pContext);
+    if (it != m_contexts.end())
+    {
+        m_contexts.erase(it);
+        bool moving = pContext->m_deviceGeneration != m_deviceGeneration;
+        delete pContext;
+        if (moving)
+        {
+            // It was still on the old device, which it no longer holds open
+            FinishMove();
+        }
+    }
+}
+
+// Loads a .wav into a new buffer; the caller owns the buffer unless it is registered with the context.
+// The returned name is a handle that stays valid if the device has to be reopened.
+inline ALuint AudioContext::CreateBuffer(const WavSourceRef& source)
+{
+    if (m_pDevice->IsOpening())
+    {
+        // Read the file while the device opens; it is uploaded in the updates after that
+        if (source)
+        {
+            source->Load();
+        }
+        ALuint handle = CreateDeferredBuffer(source);
+        if (handle)
+        {
+            m_pendingBuffers.push_back(handle);
+        }
+        return handle;
+    }
+
+    ALuint  alBuffer;
+    WavData wav;
+    try
+    {
+        MakeCurrent();
+        if (HasAlError())
+        {
+            throw ("Error occurred before loading wav");
+        }
+        if (!source)
+        {
+            throw ("No wav source");
+        }
+
+        wav      = ParseWav(source->Load());
+        alBuffer = UploadBuffer(wav);
+    }
+    catch(const char* error)
+    {
+        ReportError(std::string(error) + " : trying to load " + (source ? source->GetName() : std::string()));
+        return 0;
+    }
+
+    return AddBufferRecord(0, alBuffer, source, false, wav.loopStart, wav.loopEnd);
+}
+
+inline ALuint AudioContext::CreateBuffer(const void* pData, size_t size)
+{
+    if (m_pDevice->IsOpening())
+    {
+        // The caller's data may be gone by the time the device is ready
+        return CreateBuffer(std::make_shared<MemoryWavSource>(pData, size));
+    }
+
+    ALuint  alBuffer;
+    WavData wav;
+    try
+    {
+        MakeCurrent();
+        if (HasAlError())
+        {
+            throw ("Error occurred before loading wav");
+        }
+
+        DataSpan span = { pData, size };
+        wav      = ParseWav(span);
+        alBuffer = UploadBuffer(wav);
+    }
+    catch(const char* error)
+    {
+        ReportError(error);
+        return 0;
+    }
+
+    return AddBufferRecord(0, alBuffer, WavSourceRef(), false, wav.loopStart, wav.loopEnd);
+}
+
+// Records a buffer under the given handle, or under a fresh one if handle is 0. alBuffer is 0
+// for a deferred buffer that has not been loaded yet.
+inline ALuint AudioContext::AddBufferRecord(ALuint handle, ALuint alBuffer, const WavSourceRef& source, bool owned, ALint loopStart, ALint loopEnd)
+{
+    if (handle == 0)
+    {
+        // After a reopen or an eviction fresh names can collide with the handles of other buffers
+        handle = alBuffer ? alBuffer : ++m_lastSyntheticHandle;
+        while (m_bufferRecords.count(handle))
+        {
+            handle = ++m_lastSyntheticHandle;
+        }
+    }
+
+    BufferRecord record = { alBuffer, alBuffer ? GetBufferBytes(alBuffer) : 0, source, owned, false, loopStart, loopEnd, false, m_lru.insert(m_lru.end(), handle) };
+    m_bufferRecords[handle] = record;
+    m_residentBytes += record.bytes;
+    EnforceMemoryBudget(handle);
+    return handle;
+}
+
+inline void AudioContext::EnforceMemoryBudget(ALuint keepHandle)
+{
+    if (m_memoryBudget == 0 || m_residentBytes <= m_memoryBudget)
+    {
+        return;
+    }
+
+    // Buffers attached to a playing or paused voice stay
+    std::vector<ALuint> playing;
+    for (const Voice& voice : m_voices)
+    {
+        auto it = m_sourceBuffers.find(voice.source);
+        if (it != m_sourceBuffers.end())
+        {
+            playing.push_back(it->second);
+        }
+    }
+
+    MakeCurrent();
+    for (auto lru = m_lru.begin(); lru != m_lru.end() && m_residentBytes > m_memoryBudget;)
+    {
+        ALuint handle = *lru++;
+        BufferRecord& record = m_bufferRecords[handle];
+        if (handle == keepHandle || record.name == 0 || !record.source || record.pinned ||
+            std::find(playing.begin(), playing.end(), handle) != playing.end())
+        {
+            continue;
+        }
+
+        DetachBuffer(handle);
+        alDeleteBuffers(1, &record.name);
+        record.name = 0;
+        m_residentBytes -= record.bytes;
+        --m_numBuffers;
+        ++m_numEvictions;
+    }
+}
+
+// Takes a buffer off every source it is attached to; the sources must not be playing it
+inline void AudioContext::DetachBuffer(ALuint handle)
+{
+    for (auto it = m_sourceBuffers.begin(); it != m_sourceBuffers.end();)
+    {
+        if (it->second == handle)
+        {
+            alSourceStop(it->first);
+            alSourcei(it->first, AL_BUFFER, 0);
+            it = m_sourceBuffers.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+inline ALuint AudioContext::UploadBuffer(const WavData& wav)
+{
+    ALuint alBuffer;
+
+    // Create our openAL buffer and check for success
+    alGenBuffers(1, &alBuffer);
+    if (HasAlError())
+    {
+        throw ("alGenBuffers threw an error");
+    }
+    // Now we put our data into the openAL buffer and check for success
+    alBufferData(alBuffer, wav.format, wav.pData, wav.size, wav.frequency);
+    if (HasAlError())
+    {
+        throw ("alBufferData threw an error");
+    }
+    if (wav.loopEnd > wav.loopStart && m_hasLoopPoints)
+    {
+        ALint loopPoints[] = { wav.loopStart, wav.loopEnd };
+        alBufferiv(alBuffer, AL_LOOP_POINTS_SOFT, loopPoints);
+        if (HasAlError())
+        {
+            throw ("Error occurred setting loop points");
+        }
+    }
+    ++m_numBuffers;
+    return alBuffer;
+}
+
+inline ALint AudioContext::GetBufferBytes(ALuint alBuffer)
+{
+    ALint bytes = 0;
+    alGetBufferi(alBuffer, m_hasBufferSamples ? AL_BYTE_LENGTH_SOFT : AL_SIZE, &bytes);
+    return bytes;
+}
+
+inline void AudioContext::DestroyBuffer(ALuint alBuffer)
+{
+    try
+    {
+        MakeCurrent();
+        ALuint name = alBuffer;
+        auto it = m_bufferRecords.find(alBuffer);
+        if (it != m_bufferRecords.end())
+        {
+            name = it->second.name;
+            if (name)
+            {
+                m_residentBytes -= it->second.bytes;
+            }
+            DetachBuffer(alBuffer);
+            m_lru.erase(it->second.lru);
+            m_bufferRecords.erase(it);
+        }
+        if (name == 0)
+        {
+            // Never restored after a reopen, nothing to delete
+            return;
+        }
+
+        alDeleteBuffers(1, &name);
+
+        if (HasAlError())
+        {
+            throw ("Error occurred deleting OpenAL buffer");
+        }
+        --m_numBuffers;
+    }
+    catch(const char* error)
+    {
+        ReportError(error);
+    }
+}
+
+
+// The free functions below act on the default context. If the default device could not be
+// opened there is none; they then do nothing and sounds created without a context stay silent.
+
+// Opens the default device and creates the default context
+static void InitOpenAL()
+{
+    g_pDefaultDevice  = new AudioDevice();
+    g_pDefaultContext = g_pDefaultDevice->CreateContext();
+}
+
+// Opens the default device on a background thread and returns at once. Sounds can be created
+// and played right away; plays are queued until the first UpdateOpenAL after the device is ready.
+static void InitOpenALAsync()
+{
+    g_pDefaultDevice  = new AudioDevice(NULL, true);
+    g_pDefaultContext = g_pDefaultDevice->CreateContext();
+}
+
+// Makes the default device an offline loopback renderer; pull its output with RenderOpenAL
+static void InitOpenALLoopback(ALCsizei frequency = 44100, ALCenum channels = ALC_STEREO_SOFT, ALCenum type = ALC_SHORT_SOFT)
+{
+    LoopbackFormat format = { frequency, channels, type };
+    g_pDefaultDevice  = new AudioDevice(format);
+    g_pDefaultContext = g_pDefaultDevice->CreateContext();
+}
+
+// Renders the next frames of the default loopback device into pBuffer
+static void RenderOpenAL(void* pBuffer, ALCsizei frames)
+{
+    if (g_pDefaultDevice)
+    {
+        g_pDefaultDevice->Render(pBuffer, frames);
+    }
+}
+
+static void DestroyOpenAL()
+{
+    delete g_pDefaultDevice;
+    g_pDefaultDevice  = NULL;
+    g_pDefaultContext = NULL;
+}
+
+static void SetListenerPosition(const Vec3& position)
+{
+    if (g_pDefaultContext)
+    {
+        g_pDefaultContext->SetListenerPosition(position);
+    }
+}
+
+static void SetListenerVelocity(const Vec3& velocity)
+{
+    if (g_pDefaultContext)
+    {
+        g_pDefaultContext->SetListenerVelocity(velocity);
+    }
+}
+
+static void SetListenerOrientation(const Vec3& forward, const Vec3& up)
+{
+    if (g_pDefaultContext)
+    {
+        g_pDefaultContext->SetListenerOrientation(forward, up);
+    }
+}
+
+static void SetListenerGain(const float& gain)
+{
+    if (g_pDefaultContext)
+    {
+        g_pDefaultContext->SetListenerGain(gain);
+    }
+}
+
+// Optional interface call for apps that wish to reuse buffers
+template<typename Source>
+ALuint CreateBuffer(const Source& source)
+{
+    return g_pDefaultContext ? g_pDefaultContext->CreateBuffer(source) : 0;
+}
+
+static ALuint CreateBuffer(const void* pData, size_t size)
+{
+    return g_pDefaultContext ? g_pDefaultContext->CreateBuffer(pData, size) : 0;
+}
+
+template<typename Source>
+ALuint CreateDeferredBuffer(const Source& source)
+{
+    return g_pDefaultContext ? g_pDefaultContext->CreateDeferredBuffer(source) : 0;
+}
+
+static void Prewarm(const std::vector<ALuint>& buffers, bool pin = false)
+{
+    if (g_pDefaultContext)
+    {
+        g_pDefaultContext->Prewarm(buffers, pin);
+    }
+}
+
+static void DestroyBuffer(ALuint alBuffer)
+{
+    if (g_pDefaultContext)
+    {
+        g_pDefaultContext->DestroyBuffer(alBuffer);
+    }
+}
+
+static void UpdateOpenAL()
+{
+    if (g_pDefaultContext)
+    {
+        g_pDefaultContext->Update();
+    }
+}
+
+// The length of a buffer in sample frames
+static ALint GetBufferFrames(ALuint alBuffer)
+{
+    ALint size, channels, bits;
+    alGetBufferi(alBuffer, AL_SIZE,     &size);
+    alGetBufferi(alBuffer, AL_CHANNELS, &channels);
+    alGetBufferi(alBuffer, AL_BITS,     &bits);
+    if (channels <= 0 || bits <= 0)
+    {
+        return 0;
+    }
+    return size / (channels * (bits / 8));
+}
+
+// Attenuation of a source at a distance under an AL distance model, as the mixer applies it
+static float GetDistanceGain(ALenum model, float distance, float reference, float maxDistance, float rolloff)
+{
+    bool clamped = model == AL_INVERSE_DISTANCE_CLAMPED || model == AL_LINEAR_DISTANCE_CLAMPED || model == AL_EXPONENT_DISTANCE_CLAMPED;
+    if (clamped)
+    {
+        distance = std::max(reference, std::min(distance, maxDistance));
+    }
+
+    switch (model)
+    {
+        case AL_INVERSE_DISTANCE:
+        case AL_INVERSE_DISTANCE_CLAMPED:
+        {
+            float denominator = reference + rolloff * (distance - reference);
+            return denominator > 0.f ? reference / denominator : 1.f;
+        }
+        case AL_LINEAR_DISTANCE:
+        case AL_LINEAR_DISTANCE_CLAMPED:
+            return maxDistance > reference ? std::max(0.f, 1.f - rolloff * (std::min(distance, maxDistance) - reference) / (maxDistance - reference)) : 1.f;
+        case AL_EXPONENT_DISTANCE:
+        case AL_EXPONENT_DISTANCE_CLAMPED:
+            return distance > 0.f && reference > 0.f ? std::pow(distance / reference, -rolloff) : 1.f;
+        default:
+            return 1.f;
+    }
+}
+
+// TODO: allow users to create and manage their own sources
+
+
+class Sound
+{
+public:
+    float       m_pitch;
+    float       m_gain;
+    Vec3        m_position;
+    Vec3        m_velocity;
+    bool        m_looping;
+    ALuint      m_effectSlot;   // AudioContext::CreateReverbSlot handle the sound sends into, 0 for none
+    float       m_referenceDistance;
+    float       m_maxDistance;
+    float       m_rolloffFactor;
+    unsigned int m_bus;         // AudioContext::CreateBus handle the sound plays through; takes effect on the next play
+
+    // Sounds play in the default context unless a context is given. Without any context, such
+    // as when the default device failed to open, or once the context is destroyed, the sound
+    // does nothing.
+    Sound(const ALuint& alBuffer, AudioContext* pContext = NULL) : 
+		m_pitch(1.f), m_gain(1.f), m_position(0.f, 0.f, 0.f), m_velocity(0.f, 0.f, 0.f), m_looping(false), m_effectSlot(0),
+		m_referenceDistance(1.f), m_maxDistance(FLT_MAX), m_rolloffFactor(1.f), m_bus(MasterBus),
+		m_pContext(pContext ? pContext : g_pDefaultContext), m_buffer(alBuffer), m_source(0), m_generation(m_pContext ? m_pContext->m_generation : 0), m_frequency(0), m_frames(0), m_loopStart(0), m_loopEnd(0)
+    {
+        if (m_pContext)
+        {
+            m_pContext->m_sounds.insert(this);
+        }
+    }
+
+    // Convenience function if not reusing buffer; takes a WavSourceRef or anything
+    // WavSourceTraits can read, such as a ci::DataSourceRef with OpenAL.h. The .wav is not
+    // read until the sound is first played; use AudioContext::Prewarm with GetBuffer() to
+    // load it ahead of time.
+    template<typename Source>
+    Sound(const Source& source, AudioContext* pContext = NULL, typename std::enable_if<!std::is_arithmetic<Source>::value>::type* = NULL) : 
+		m_pitch(1.f), m_gain(1.f), m_position(0.f, 0.f, 0.f), m_velocity(0.f, 0.f, 0.f), m_looping(false), m_effectSlot(0),
+		m_referenceDistance(1.f), m_maxDistance(FLT_MAX), m_rolloffFactor(1.f), m_bus(MasterBus),
+		m_pContext(pContext ? pContext : g_pDefaultContext), m_buffer(0), m_source(0), m_generation(m_pContext ? m_pContext->m_generation : 0), m_frequency(0), m_frames(0), m_loopStart(0), m_loopEnd(0)
+    {
+        if (m_pContext)
+        {
+            m_pContext->m_sounds.insert(this);
+            m_buffer = m_pContext->CreateDeferredBuffer(source);
+            m_pContext->RegisterBuffer(m_buffer);
+        }
+    }
+
+    ~Sound()
+    {
+        if (m_pContext)
+        {
+            Stop();
+            m_pContext->ForgetSound(this);
+        }
+    }
+
+    // Convenience function for playing an "overlapping" sound (instead of restarting the sound)
+    void Play(bool overlap = true)
+    {
+        if (!m_pContext)
+        {
+            return;
+        }
+        if (m_pContext->GetDevice()->IsOpening())
+        {
+            // Starts from the beginning in the first update after the device is ready
+            m_pContext->QueuePlay(this, overlap);
+            return;
+        }
+        Start(overlap, 0.0);
+    }
+
+    // Schedules the first sample to be heard at deviceTime (see AudioContext::GetDeviceTime).
+    // Requires AudioContext::Update every frame; starts that come due between updates are
+    // compensated by seeking into the buffer so the sound stays on the device timeline.
+    void PlayAt(double deviceTime, bool overlap = true)
+    {
+        if (m_pContext)
+        {
+            m_pContext->SchedulePlay(this, deviceTime, overlap);
+        }
+    }
+
+    void Stop()
+    {
+        if (!m_pContext)
+        {
+            return;
+        }
+        try
+        {
+            m_pContext->CancelScheduled(this);
+            if (!m_pContext->IsValid())
+            {
+                // Nothing has reached AL yet
+                return;
+            }
+            m_pContext->MakeCurrent();
+            if (m_generation != m_pContext->m_generation)
+            {
+                m_source     = 0;
+                m_generation = m_pContext->m_generation;
+            }
+            if (m_source)
+            {
+                alSourceStop(m_source);
+                m_pContext->ReleaseSource(m_source);
+                m_source = 0;
+            }
+            m_clock.Reset();
+
+            if (HasAlError())
+            {
+                throw ("Error occurred stopping OpenAL sound");
+            }
+        }
+        catch(const char* error)
+        {
+            ReportError(error);
+        }
+    }
+
+    // Moves m_gain to gain over seconds, along a curve, and the playing voice with it at each
+    // AudioContext::Update. A fade of 0 seconds sets the gain at the next update.
+    void FadeTo(float gain, double seconds, FadeCurve curve = FadeLinear)
+    {
+        if (m_pContext)
+        {
+            m_pContext->AddFade(this, false, gain, seconds, curve, false);
+        }
+    }
+
+    // Fades to silence and stops; m_gain is put back afterwards for the next play
+    void FadeOut(double seconds, FadeCurve curve = FadeLinear)
+    {
+        if (m_pContext)
+        {
+            m_pContext->AddFade(this, false, 0.f, seconds, curve, true);
+        }
+    }
+
+    // Moves m_pitch to pitch over seconds, like FadeTo
+    void RampPitch(float pitch, double seconds, FadeCurve curve = FadeLinear)
+    {
+        if (m_pContext)
+        {
+            m_pContext->AddFade(this, true, pitch, seconds, curve, false);
+        }
+    }
+
+    void Pause()
+    {
+        try
+        {
+            if (!m_pContext || !m_pContext->IsValid())
+            {
+                return;
+            }
+            m_pContext->MakeCurrent();
+            if (m_source && m_generation == m_pContext->m_generation)
+            {
+                alSourcePause(m_source);
+            }
+
+            if (HasAlError())
+            {
+                throw ("Error occurred pausing OpenAL sound");
+            }
+        }
+        catch(const char* error)
+        {
+            ReportError(error);
+        }
+    }
+
+    // Audible position of the most recently played voice as of the last AudioContext::Update,
+    // extrapolated to now. Lock-free and safe to call from a render thread every frame.
+    PlaybackPosition GetPlaybackPosition() const
+    {
+        return m_clock.Read(m_pContext ? m_pContext->GetDeviceTime() : 0.0);
+    }
+
+    AudioContext* GetContext() const { return m_pContext; }
+
+    // The buffer handle this sound plays
+    ALuint GetBuffer() const { return m_buffer; }
+
+    // The AL source of the sound's most recent voice, 0 if it has none; for reading AL
+    // properties the block does not track. Changes when the sound plays again.
+    ALuint GetAlSource() const { return m_source; }
+
+private:
+    AudioContext*       m_pContext;
+    ALuint              m_buffer;
+    ALuint              m_source;   // most recently played source
+    unsigned int        m_generation;   // of the context m_source was created in
+    ALint               m_frequency;
+    ALint               m_frames;
+    ALint               m_loopStart;    // loop points of the buffer as of the last play
+    ALint               m_loopEnd;
+    VoiceClock          m_clock;
+
+    // Buffer properties are cached on first use so playing does not query them
+    void LoadBufferInfo()
+    {
+        if (m_frames == 0)
+        {
+            ALuint buffer = m_pContext->ResolveBuffer(m_buffer);
+            alGetBufferi(buffer, AL_FREQUENCY, &m_frequency);
+            m_frames = GetBufferFrames(buffer);
+        }
+    }
+
+    void PublishClock(double deviceTime, double audibleFrame, bool playing)
+    {
+        m_clock.Publish(deviceTime, audibleFrame, playing ? m_frequency * m_pitch : 0.0, m_frequency, m_frames, m_looping, m_loopStart, m_loopEnd);
+    }
+
+    friend class AudioContext;
+
+    // Starts playback, skipping what would have played over skipSeconds of device time
+    void Start(bool overlap, double skipSeconds)
+    {
+        if (!m_pContext->IsValid())
+        {
+            // No AL context to play on, as when the device failed to open
+            return;
+        }
+        if (!m_pContext->IsAudible(*this))
+        {
+            m_pContext->Cull(this, overlap, skipSeconds);
+            return;
+        }
+
+        try
+        {
+            m_pContext->MakeCurrent();
+            if (m_generation != m_pContext->m_generation)
+            {
+                // The source went away with the device
+                m_source     = 0;
+                m_generation = m_pContext->m_generation;
+            }
+
+            if (m_source == 0)
+            {
+                m_source = GetSource();
+            }
+            else
+            {
+                ALenum state;
+                alGetSourcei(m_source, AL_SOURCE_STATE, &state);
+                if (state == AL_PLAYING)
+                {
+                    if (overlap)
+                    {
+                        m_pContext->ReleaseSource(m_source);
+                        m_source = GetSource();
+                    }
+                }
+            }
+            if (m_source == 0)
+            {
+                throw ("No source available to play OpenAL sound");
+            }
+
+            // Loads the buffer if it is deferred or was evicted since this source last played it
+            if (m_pContext->BindBuffer(m_source, m_buffer) == 0)
+            {
+                throw ("No buffer to play OpenAL sound");
+            }
+
+            LoadBufferInfo();
+            m_pContext->GetLoopPoints(m_buffer, m_loopStart, m_loopEnd);
+            ALint startOffset = 0;
+            if (skipSeconds > 0.0)
+            {
+                // Frames go by pitch times faster than the device clock
+                ALint offset = static_cast<ALint>(skipSeconds * m_frequency * m_pitch + 0.5);
+                if (m_looping && m_loopEnd > m_loopStart)
+                {
+                    // Past the intro, skip around the loop
+                    offset = static_cast<ALint>(WrapLoopFrame(offset, m_loopStart, m_loopEnd));
+                }
+                else if (m_looping && m_frames > 0)
+                {
+                    offset %= m_frames;
+                }
+                else if (offset >= m_frames)
+                {
+                    // Came due after the sound would already have finished
+                    alSourceRewind(m_source);
+                    return;
+                }
+                alSourcei(m_source, AL_SAMPLE_OFFSET, offset);
+                startOffset = offset;
+            }
+
+            // Set on every play since the bus or m_effectSlot may have changed while the source sat idle
+            alSourcef(m_source, AL_GAIN, m_gain * m_pContext->GetBusGain(m_bus));
+            m_pContext->BindEffectSlot(m_source, m_effectSlot);
+            alSourcePlay(m_source);
+            m_pContext->AddVoice(m_source, this, startOffset, m_frequency, m_pitch, m_bus, m_gain);
+
+            // Nothing is heard until the output latency has passed
+            PublishClock(m_pContext->GetDeviceTime(), startOffset - m_pContext->GetOutputLatency() * m_frequency * m_pitch, true);
+
+            if (HasAlError())
+            {
+                throw ("Error occurred playing OpenAL sound");
+            }
+        }
+        catch(const char* error)
+        {
+            ReportError(error);
+        }
+    }
+
+    // reuses sources if possible, otherwise creates new sources
+    ALuint GetSource()
+    {
+        ALuint alSource = 0;
+        try
+        {
+            alSource = m_pContext->AcquireSource();
+
+            if (alSource)
+            {
+                ALfloat sourcePos[] = { m_position.x, m_position.y, m_position.z };
+                ALfloat sourceVel[] = { m_velocity.x, m_velocity.y, m_velocity.z };
+
+                alSourcef (alSource, AL_PITCH,    m_pitch);
+                alSourcefv(alSource, AL_POSITION, sourcePos);
+                alSourcefv(alSource, AL_VELOCITY, sourceVel);
+                alSourcei (alSource, AL_LOOPING,  m_looping );
+                alSourcef (alSource, AL_REFERENCE_DISTANCE, m_referenceDistance);
+                alSourcef (alSource, AL_MAX_DISTANCE,       m_maxDistance);
+                alSourcef (alSource, AL_ROLLOFF_FACTOR,     m_rolloffFactor);
+                if (HasAlError())
+                {
+                    throw ("Error setting source parameters");
+                }
+            }
+        }
+        catch(const char* error)
+        {
+            ReportError(error);
+            alSource = 0;
+        }
+        return alSource;
+    }
+};
+
+inline ALuint AudioContext::CreateReverbSlot(const EFXEAXREVERBPROPERTIES& preset, float gain)
+{
+    if (IsValid() && !m_efx.IsSupported())
+    {
+        ReportError("ALC_EXT_EFX is not supported; no reverb slot created");
+        return 0;
+    }
+
+    // Created now, or once a device that is still opening is ready
+    EffectSlotRecord record = { 0, 0, preset, gain };
+    if (IsValid())
+    {
+        MakeCurrent();
+        CreateEffectSlot(record);
+    }
+    ALuint handle = ++m_lastEffectSlotHandle;
+    m_effectSlots[handle] = record;
+    return handle;
+}
+
+inline void AudioContext::SetReverbPreset(ALuint slot, const EFXEAXREVERBPROPERTIES& preset)
+{
+    auto it = m_effectSlots.find(slot);
+    if (it == m_effectSlots.end())
+    {
+        return;
+    }
+
+    EffectSlotRecord& record = it->second;
+    record.preset = preset;
+    if (record.slot)
+    {
+        // A slot copies the effect when it is attached, so attach it again after the change
+        MakeCurrent();
+        LoadReverbPreset(m_efx, record.effect, preset);
+        OPENAL_CALL(m_efx.alAuxiliaryEffectSloti, record.slot, AL_EFFECTSLOT_EFFECT, record.effect);
+    }
+}
+
+inline void AudioContext::SetEffectSlotGain(ALuint slot, float gain)
+{
+    auto it = m_effectSlots.find(slot);
+    if (it == m_effectSlots.end())
+    {
+        return;
+    }
+
+    it->second.gain = gain;
+    if (it->second.slot)
+    {
+        MakeCurrent();
+        OPENAL_CALL(m_efx.alAuxiliaryEffectSlotf, it->second.slot, AL_EFFECTSLOT_GAIN, gain);
+    }
+}
+
+inline void AudioContext::DestroyEffectSlot(ALuint slot)
+{
+    auto it = m_effectSlots.find(slot);
+    if (it == m_effectSlots.end())
+    {
+        return;
+    }
+
+    MakeCurrent();
+    for (auto source = m_sourceSlots.begin(); source != m_sourceSlots.end();)
+    {
+        if (source->second == slot)
+        {
+            alSource3i(source->first, AL_AUXILIARY_SEND_FILTER, AL_EFFECTSLOT_NULL, 0, AL_FILTER_NULL);
+            source = m_sourceSlots.erase(source);
+        }
+        else
+        {
+            ++source;
+        }
+    }
+    DeleteEffectSlot(it->second);
+    m_effectSlots.erase(it);
+}
+
+inline void AudioContext::UpdateReverbZones()
+{
+    Vec3 listener(m_listenerPosition[0], m_listenerPosition[1], m_listenerPosition[2]);
+    if (m_zoneSlot == 0 || (!m_zonesChanged &&
+        listener.x == m_zoneListener.x && listener.y == m_zoneListener.y && listener.z == m_zoneListener.z))
+    {
+        return;
+    }
+    m_zoneListener = listener;
+    m_zonesChanged = false;
+
+    EFXEAXREVERBPROPERTIES preset = m_reverbZones.Evaluate(listener, m_outsidePreset);
+    if (ReverbPresetsDiffer(preset, m_zonePreset))
+    {
+        m_zonePreset = preset;
+        SetReverbPreset(m_zoneSlot, preset);
+    }
+}
+
+inline void AudioContext::UpdateOcclusion(double now)
+{
+    double elapsed = now - m_lastOcclusionTime;
+    m_lastOcclusionTime = now;
+    m_occlusionRays     = 0;
+    if (!m_occlusionQuery || !m_efx.IsSupported() || m_voices.empty())
+    {
+        return;
+    }
+
+    // Newly started voices first so they do not start unfiltered, then the rest in turn
+    m_occlusionVoices.clear();
+    m_occlusionEmitters.clear();
+    for (size_t i = 0; i < m_voices.size() && m_occlusionVoices.size() < m_raysPerUpdate; ++i)
+    {
+        if (!m_voices[i].occlusionQueried && m_voices[i].pSound)
+        {
+            m_occlusionVoices.push_back(i);
+        }
+    }
+    for (size_t n = 0; n < m_voices.size() && m_occlusionVoices.size() < m_raysPerUpdate; ++n)
+    {
+        size_t i = m_occlusionCursor++ % m_voices.size();
+        if (m_voices[i].occlusionQueried && m_voices[i].pSound)
+        {
+            m_occlusionVoices.push_back(i);
+        }
+    }
+
+    if (!m_occlusionVoices.empty())
+    {
+        for (size_t i : m_occlusionVoices)
+        {
+            m_occlusionEmitters.push_back(m_voices[i].pSound->m_position);
+        }
+        m_occlusionResults.assign(m_occlusionVoices.size(), 0.f);
+        Vec3 listener(m_listenerPosition[0], m_listenerPosition[1], m_listenerPosition[2]);
+        m_occlusionQuery(listener, &m_occlusionEmitters[0], &m_occlusionResults[0], m_occlusionVoices.size());
+        m_occlusionRays = static_cast<unsigned int>(m_occlusionVoices.size());
+
+        for (size_t n = 0; n < m_occlusionVoices.size(); ++n)
+        {
+            Voice& voice = m_voices[m_occlusionVoices[n]];
+            voice.occlusionTarget = std::min(1.f, std::max(0.f, m_occlusionResults[n]));
+            if (!voice.occlusionQueried)
+            {
+                voice.occlusion        = voice.occlusionTarget;
+                voice.occlusionQueried = true;
+            }
+        }
+    }
+
+    // Only filters that moved audibly are rewritten
+    float step = m_occlusionSmoothing > 0.0 ? static_cast<float>(1.0 - std::exp(-elapsed / m_occlusionSmoothing)) : 1.f;
+    for (Voice& voice : m_voices)
+    {
+        voice.occlusion += (voice.occlusionTarget - voice.occlusion) * step;
+        if (std::fabs(voice.occlusion - voice.occlusionWritten) > 0.01f ||
+            (voice.occlusion < 0.01f && voice.occlusionWritten > 0.f))
+        {
+            ApplyOcclusion(voice.source, voice.occlusion);
+            voice.occlusionWritten = voice.occlusion < 0.01f ? 0.f : voice.occlusion;
+        }
+    }
+}
+
+inline unsigned int AudioContext::AddEmitter(Sound* pSound, float radius)
+{
+    auto it = m_soundEmitters.find(pSound);
+    if (it != m_soundEmitters.end())
+    {
+        SetEmitterRadius(it->second, radius);
+        return it->second;
+    }
+
+    unsigned int id = m_emitterGrid.Add(pSound->m_position, radius);
+    EmitterRecord record = { pSound, GetDeviceTime() };
+    m_emitters[id]          = record;
+    m_soundEmitters[pSound] = id;
+    m_emittersChanged       = true;
+    return id;
+}
+
+inline void AudioContext::RemoveEmitter(unsigned int emitter)
+{
+    auto it = m_emitters.find(emitter);
+    if (it == m_emitters.end())
+    {
+        return;
+    }
+
+    Sound* pSound = it->second.pSound;
+    m_emitterGrid.Remove(emitter);
+    m_soundEmitters.erase(pSound);
+    m_emitters.erase(it);
+
+    auto inRange = std::lower_bound(m_emittersInRange.begin(), m_emittersInRange.end(), emitter);
+    if (inRange != m_emittersInRange.end() && *inRange == emitter)
+    {
+        m_emittersInRange.erase(inRange);
+        pSound->Stop();
+    }
+}
+
+inline void AudioContext::MoveEmitter(unsigned int emitter, const Vec3& position)
+{
+    auto it = m_emitters.find(emitter);
+    if (it == m_emitters.end())
+    {
+        return;
+    }
+
+    Sound* pSound = it->second.pSound;
+    pSound->m_position = position;
+    m_emitterGrid.Move(emitter, position);
+    m_emittersChanged = true;
+    if (pSound->m_source && pSound->m_generation == m_generation && IsValid())
+    {
+        MakeCurrent();
+        ALfloat sourcePos[] = { position.x, position.y, position.z };
+        alSourcefv(pSound->m_source, AL_POSITION, sourcePos);
+    }
+}
+
+inline void AudioContext::SetEmitterRadius(unsigned int emitter, float radius)
+{
+    m_emitterGrid.SetRadius(emitter, radius);
+    m_emittersChanged = true;
+}
+
+inline void AudioContext::ResolveBuses()
+{
+    if (!m_busesDirty)
+    {
+        return;
+    }
+    m_busesDirty = false;
+
+    for (size_t i = 0; i < m_buses.size(); ++i)
+    {
+        Bus& bus = m_buses[i];
+        float gain = bus.muted ? 0.f : bus.volume * bus.duck * (i == MasterBus ? 1.f : m_buses[bus.parent].gain);
+        if (gain != bus.gain)
+        {
+            bus.gain       = gain;
+            bus.changed    = true;
+            m_busesChanged = true;
+        }
+    }
+}
+
+inline void AudioContext::AddFade(Sound* pSound, bool pitch, float to, double seconds, FadeCurve curve, bool stopAtEnd)
+{
+    float from = pitch ? pSound->m_pitch : pSound->m_gain;
+    Fade fade = { pSound, pitch, curve, stopAtEnd, from, to, from, GetDeviceTime(), std::max(0.0, seconds) };
+
+    // A new fade takes over from the one in progress, starting where it had got to
+    for (Fade& existing : m_fades)
+    {
+        if (existing.pSound == pSound && existing.pitch == pitch)
+        {
+            existing = fade;
+            return;
+        }
+    }
+    m_fades.push_back(fade);
+}
+
+// Shapes progress t in [0, 1] along a curve from one value to another
+static float GetFadeValue(FadeCurve curve, float from, float to, float t)
+{
+    const float quarterTurn = 1.5707963f;
+    switch (curve)
+    {
+        case FadeSmooth:
+            t = t * t * (3.f - 2.f * t);
+            break;
+        case FadeEqualPower:
+            t = to > from ? std::sin(t * quarterTurn) : 1.f - std::cos(t * quarterTurn);
+            break;
+        case FadeExponential:
+        {
+            const float floor = 0.0001f;
+            float low  = std::max(floor, from);
+            float high = std::max(floor, to);
+            float value = low * std::pow(high / low, t);
+            return t >= 1.f ? to : (value <= floor ? std::min(from, to) : value);
+        }
+        default:
+            break;
+    }
+    return from + (to - from) * t;
+}
+
+inline void AudioContext::UpdateFades(double now)
+{
+    if (m_fades.empty())
+    {
+        return;
+    }
+
+    // Values for every fade first, then AL only for the voices whose value moved
+    bool finished = false;
+    for (Fade& fade : m_fades)
+    {
+        float t = fade.duration > 0.0 ? static_cast<float>(std::min(1.0, (now - fade.startTime) / fade.duration)) : 1.f;
+        fade.value = GetFadeValue(fade.curve, fade.from, fade.to, t);
+        finished   = finished || t >= 1.f;
+    }
+
+    for (const Fade& fade : m_fades)
+    {
+        Sound* pSound = fade.pSound;
+        if (fade.pitch)
+        {
+            pSound->m_pitch = fade.value;
+        }
+        else
+        {
+            pSound->m_gain = fade.value;
+        }
+        if (pSound->m_source == 0 || pSound->m_generation != m_generation)
+        {
+            continue;
+        }
+        for (Voice& voice : m_voices)
+        {
+            if (voice.source != pSound->m_source)
+            {
+                continue;
+            }
+            if (fade.pitch && voice.pitch != fade.value)
+            {
+                voice.pitch = fade.value;
+                alSourcef(voice.source, AL_PITCH, fade.value);
+            }
+            else if (!fade.pitch && voice.gain != fade.value)
+            {
+                voice.gain = fade.value;
+                alSourcef(voice.source, AL_GAIN, fade.value * m_buses[voice.bus].gain);
+            }
+            break;
+        }
+    }
+
+    if (!finished)
+    {
+        return;
+    }
+    for (size_t i = 0; i < m_fades.size();)
+    {
+        Fade& fade = m_fades[i];
+        if (fade.duration > 0.0 && now - fade.startTime < fade.duration)
+        {
+            ++i;
+            continue;
+        }
+        if (fade.stopAtEnd)
+        {
+            // Back to the gain from before the fade, so the next play is heard
+            fade.pSound->Stop();
+            fade.pSound->m_gain = fade.from;
+        }
+        m_fades[i] = m_fades.back();
+        m_fades.pop_back();
+    }
+}
+
+inline void AudioContext::UpdateVelocities(double now)
+{
+    double elapsed = now - m_lastVelocityTime;
+    if (!m_autoVelocity || elapsed <= 0.0)
+    {
+        return;
+    }
+    m_lastVelocityTime = now;
+    float perSecond = static_cast<float>(1.0 / elapsed);
+    float step      = m_velocitySmoothing > 0.0 ? static_cast<float>(1.0 - std::exp(-elapsed / m_velocitySmoothing)) : 1.f;
+
+    Vec3 listener(m_listenerPosition[0], m_listenerPosition[1], m_listenerPosition[2]);
+    Vec3 listenerVelocity(m_listenerVelocity[0], m_listenerVelocity[1], m_listenerVelocity[2]);
+    listenerVelocity = listenerVelocity + ((listener - m_lastListenerPosition) * perSecond - listenerVelocity) * step;
+    m_lastListenerPosition = listener;
+    if (Length(listenerVelocity) < 0.001f)
+    {
+        // Settle at rest rather than decaying forever
+        listenerVelocity = Vec3();
+    }
+    if (listenerVelocity.x != m_listenerVelocity[0] || listenerVelocity.y != m_listenerVelocity[1] || listenerVelocity.z != m_listenerVelocity[2])
+    {
+        SetListenerVelocity(listenerVelocity);
+    }
+
+    // Gather the current voice of each sound
+    m_motion.Clear();
+    for (size_t i = 0; i < m_voices.size(); ++i)
+    {
+        Voice& voice = m_voices[i];
+        if (!voice.pSound || voice.pSound->m_source != voice.source)
+        {
+            continue;
+        }
+        const Vec3& position = voice.pSound->m_position;
+        if (!voice.tracked)
+        {
+            // The source was started at this position with the sound's own velocity
+            voice.tracked  = true;
+            voice.position = position;
+            voice.velocity = voice.pSound->m_velocity;
+        }
+        m_motion.voices.push_back(i);
+        m_motion.x.push_back(position.x);           m_motion.y.push_back(position.y);           m_motion.z.push_back(position.z);
+        m_motion.lx.push_back(voice.position.x);    m_motion.ly.push_back(voice.position.y);    m_motion.lz.push_back(voice.position.z);
+        m_motion.vx.push_back(voice.velocity.x);    m_motion.vy.push_back(voice.velocity.y);    m_motion.vz.push_back(voice.velocity.z);
+    }
+
+    size_t count = m_motion.voices.size();
+    float* x  = count ? &m_motion.x[0]  : NULL;
+    float* y  = count ? &m_motion.y[0]  : NULL;
+    float* z  = count ? &m_motion.z[0]  : NULL;
+    float* lx = count ? &m_motion.lx[0] : NULL;
+    float* ly = count ? &m_motion.ly[0] : NULL;
+    float* lz = count ? &m_motion.lz[0] : NULL;
+    float* vx = count ? &m_motion.vx[0] : NULL;
+    float* vy = count ? &m_motion.vy[0] : NULL;
+    float* vz = count ? &m_motion.vz[0] : NULL;
+    for (size_t n = 0; n < count; ++n)
+    {
+        vx[n] += ((x[n] - lx[n]) * perSecond - vx[n]) * step;
+        vy[n] += ((y[n] - ly[n]) * perSecond - vy[n]) * step;
+        vz[n] += ((z[n] - lz[n]) * perSecond - vz[n]) * step;
+    }
+    for (size_t n = 0; n < count; ++n)
+    {
+        bool atRest = vx[n] * vx[n] + vy[n] * vy[n] + vz[n] * vz[n] < 1.0e-6f;
+        vx[n] = atRest ? 0.f : vx[n];
+        vy[n] = atRest ? 0.f : vy[n];
+        vz[n] = atRest ? 0.f : vz[n];
+    }
+
+    // Write back only what changed
+    for (size_t n = 0; n < count; ++n)
+    {
+        Voice& voice = m_voices[m_motion.voices[n]];
+        Vec3 position(x[n], y[n], z[n]);
+        Vec3 velocity(vx[n], vy[n], vz[n]);
+        if (x[n] != lx[n] || y[n] != ly[n] || z[n] != lz[n])
+        {
+            ALfloat sourcePos[] = { x[n], y[n], z[n] };
+            alSourcefv(voice.source, AL_POSITION, sourcePos);
+            voice.position = position;
+        }
+        if (vx[n] != voice.velocity.x || vy[n] != voice.velocity.y || vz[n] != voice.velocity.z)
+        {
+            ALfloat sourceVel[] = { vx[n], vy[n], vz[n] };
+            alSourcefv(voice.source, AL_VELOCITY, sourceVel);
+        }
+        voice.velocity = velocity;
+        voice.pSound->m_velocity = velocity;
+    }
+}
+
+inline void AudioContext::UpdateDucking(double now)
+{
+    double elapsed = now - m_lastDuckingTime;
+    m_lastDuckingTime = now;
+    if (m_duckingRules.empty())
+    {
+        return;
+    }
+
+    // Children come after their parents, so counting back up the list totals each subtree
+    m_busVoices.assign(m_buses.size(), 0);
+    for (const Voice& voice : m_voices)
+    {
+        if (!voice.paused)
+        {
+            ++m_busVoices[voice.bus];
+        }
+    }
+    for (size_t i = m_buses.size() - 1; i > MasterBus; --i)
+    {
+        m_busVoices[m_buses[i].parent] += m_busVoices[i];
+    }
+
+    for (Bus& bus : m_buses)
+    {
+        bus.duck = 1.f;
+    }
+    for (auto& entry : m_duckingRules)
+    {
+        DuckingRule& rule = entry.second;
+        bool   active = m_busVoices[rule.trigger] > 0;
+        double time   = active ? rule.attack : rule.release;
+        float  step   = time > 0.0 ? static_cast<float>(elapsed / time) : 1.f;
+        rule.amount   = active ? std::min(1.f, rule.amount + step) : std::max(0.f, rule.amount - step);
+
+        m_buses[rule.target].duck *= 1.f + (rule.duckedGain - 1.f) * rule.amount;
+    }
+    m_busesDirty = true;
+}
+
+inline void AudioContext::UpdateBuses()
+{
+    ResolveBuses();
+    if (!m_busesChanged)
+    {
+        return;
+    }
+    m_busesChanged = false;
+
+    for (const Voice& voice : m_voices)
+    {
+        const Bus& bus = m_buses[voice.bus];
+        if (bus.changed)
+        {
+            alSourcef(voice.source, AL_GAIN, voice.gain * bus.gain);
+        }
+    }
+    for (Bus& bus : m_buses)
+    {
+        bus.changed = false;
+    }
+}
+
+inline void AudioContext::UpdateEmitters(double now)
+{
+    Vec3 listener(m_listenerPosition[0], m_listenerPosition[1], m_listenerPosition[2]);
+    if (!m_emittersChanged &&
+        listener.x == m_emitterListener.x && listener.y == m_emitterListener.y && listener.z == m_emitterListener.z)
+    {
+        return;
+    }
+    m_emitterListener = listener;
+    m_emittersChanged = false;
+
+    m_emittersFound.clear();
+    m_emitterGrid.Query(listener, m_emittersFound);
+    std::sort(m_emittersFound.begin(), m_emittersFound.end());
+
+    // Both lists are sorted, so one pass finds the emitters that left range and those that came in
+    auto was = m_emittersInRange.begin();
+    auto is  = m_emittersFound.begin();
+    while (was != m_emittersInRange.end() || is != m_emittersFound.end())
+    {
+        if (is == m_emittersFound.end() || (was != m_emittersInRange.end() && *was < *is))
+        {
+            m_emitters.find(*was++)->second.pSound->Stop();
+        }
+        else if (was == m_emittersInRange.end() || *is < *was)
+        {
+            const EmitterRecord& record = m_emitters.find(*is++)->second;
+            record.pSound->Start(false, record.pSound->m_looping ? now - record.startTime : 0.0);
+        }
+        else
+        {
+            ++was;
+            ++is;
+        }
+    }
+    m_emittersInRange.swap(m_emittersFound);
+}
+
+inline void AudioContext::ApplyOcclusion(ALuint alSource, float occlusion)
+{
+    if (occlusion < 0.01f)
+    {
+        alSourcei(alSource, AL_DIRECT_FILTER, AL_FILTER_NULL);
+        return;
+    }
+
+    if (m_occlusionFilter == 0)
+    {
+        OPENAL_CALL(m_efx.alGenFilters, 1, &m_occlusionFilter);
+        OPENAL_CALL(m_efx.alFilteri, m_occlusionFilter, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
+    }
+    OPENAL_CALL(m_efx.alFilterf, m_occlusionFilter, AL_LOWPASS_GAIN,   1.f + (m_occludedGain   - 1.f) * occlusion);
+    OPENAL_CALL(m_efx.alFilterf, m_occlusionFilter, AL_LOWPASS_GAINHF, 1.f + (m_occludedGainHF - 1.f) * occlusion);
+    alSourcei(alSource, AL_DIRECT_FILTER, m_occlusionFilter);
+}
+
+inline void AudioContext::CreateEffectSlot(EffectSlotRecord& record)
+{
+    try
+    {
+        OPENAL_CALL(m_efx.alGenEffects, 1, &record.effect);
+        OPENAL_CALL(m_efx.alGenAuxiliaryEffectSlots, 1, &record.slot);
+        if (HasAlError())
+        {
+            throw ("Error occurred creating effect slot");
+        }
+
+        LoadReverbPreset(m_efx, record.effect, record.preset);
+        OPENAL_CALL(m_efx.alAuxiliaryEffectSloti, record.slot, AL_EFFECTSLOT_EFFECT, record.effect);
+        OPENAL_CALL(m_efx.alAuxiliaryEffectSlotf, record.slot, AL_EFFECTSLOT_GAIN,   record.gain);
+        if (HasAlError())
+        {
+            throw ("Error occurred loading reverb preset");
+        }
+    }
+    catch(const char* error)
+    {
+        ReportError(error);
+    }
+}
+
+inline void AudioContext::DeleteEffectSlot(EffectSlotRecord& record)
+{
+    // The slot holds the effect, so it goes first
+    if (record.slot)
+    {
+        OPENAL_CALL(m_efx.alDeleteAuxiliaryEffectSlots, 1, &record.slot);
+    }
+    if (record.effect)
+    {
+        OPENAL_CALL(m_efx.alDeleteEffects, 1, &record.effect);
+    }
+    record.slot   = 0;
+    record.effect = 0;
+}
+
+inline bool AudioContext::IsAudible(const Sound& sound) const
+{
+    if (m_audibilityThreshold <= 0.f)
+    {
+        return true;
+    }
+
+    Vec3  listener(m_listenerPosition[0], m_listenerPosition[1], m_listenerPosition[2]);
+    float distance = Length(sound.m_position - listener);
+    float gain     = sound.m_gain * GetDistanceGain(m_distanceModel, distance, sound.m_referenceDistance, sound.m_maxDistance, sound.m_rolloffFactor);
+    return gain >= m_audibilityThreshold;
+}
+
+inline void AudioContext::Cull(Sound* pSound, bool overlap, double skipSeconds)
+{
+    ++m_numCulled;
+    if (!overlap)
+    {
+        // A restart replaces whatever the sound was playing, heard or not
+        m_virtualPlays.erase(std::remove_if(m_virtualPlays.begin(), m_virtualPlays.end(),
+            [pSound](const ScheduledPlay& play) { return play.pSound == pSound; }), m_virtualPlays.end());
+        if (pSound->m_source && pSound->m_generation == m_generation)
+        {
+            MakeCurrent();
+            alSourceStop(pSound->m_source);
+            ReleaseSource(pSound->m_source);
+            pSound->m_source = 0;
+            pSound->m_clock.Reset();
+        }
+    }
+    if (pSound->m_looping)
+    {
+        ScheduledPlay play = { pSound, GetDeviceTime() - skipSeconds, overlap };
+        m_virtualPlays.push_back(play);
+    }
+}
+
+inline void AudioContext::SchedulePlay(Sound* pSound, double deviceTime, bool overlap)
+{
+    // Start right away if the time is already within the output latency, as Update would
+    double audibleTime = GetDeviceTime() + GetOutputLatency();
+    if (deviceTime <= audibleTime && IsValid())
+    {
+        pSound->Start(overlap, audibleTime - deviceTime);
+        return;
+    }
+
+    ScheduledPlay play = { pSound, deviceTime, overlap };
+    m_scheduled.push_back(play);
+}
+
+inline void AudioContext::CancelScheduled(Sound* pSound)
+{
+    m_scheduled.erase(std::remove_if(m_scheduled.begin(), m_scheduled.end(),
+        [pSound](const ScheduledPlay& play) { return play.pSound == pSound; }), m_scheduled.end());
+    m_queuedPlays.erase(std::remove_if(m_queuedPlays.begin(), m_queuedPlays.end(),
+        [pSound](const ScheduledPlay& play) { return play.pSound == pSound; }), m_queuedPlays.end());
+    m_virtualPlays.erase(std::remove_if(m_virtualPlays.begin(), m_virtualPlays.end(),
+        [pSound](const ScheduledPlay& play) { return play.pSound == pSound; }), m_virtualPlays.end());
+}
+
+inline void AudioContext::SetLoopPoints(ALuint alBuffer, ALint startFrame, ALint endFrame)
+{
+    try
+    {
+        auto it = m_bufferRecords.find(alBuffer);
+        if (it == m_bufferRecords.end())
+        {
+            throw ("Loop points set on an unknown buffer");
+        }
+        if (!m_hasLoopPoints && IsValid())
+        {
+            throw ("Loop points need AL_SOFT_loop_points");
+        }
+        if (startFrame < 0 || (endFrame != 0 && endFrame <= startFrame))
+        {
+            throw ("Invalid loop points");
+        }
+
+        BufferRecord& record = it->second;
+        if (record.name)
+        {
+            // AL refuses to change the loop points of a buffer attached to any source
+            for (const Voice& voice : m_voices)
+            {
+                auto attached = m_sourceBuffers.find(voice.source);
+                if (attached != m_sourceBuffers.end() && attached->second == alBuffer)
+                {
+                    throw ("Loop points set on a buffer that is playing");
+                }
+            }
+            MakeCurrent();
+            DetachBuffer(alBuffer);
+
+            ALint frames = GetBufferFrames(record.name);
+            ALint loopPoints[] = { endFrame ? startFrame : 0, endFrame ? endFrame : frames };
+            if (loopPoints[1] > frames)
+            {
+                throw ("Invalid loop points");
+            }
+            alBufferiv(record.name, AL_LOOP_POINTS_SOFT, loopPoints);
+            if (HasAlError())
+            {
+                throw ("Error occurred setting loop points");
+            }
+        }
+
+        // Kept so the points survive an eviction or a reopen
+        record.loopStart = endFrame ? startFrame : 0;
+        record.loopEnd   = endFrame;
+        record.loopSet   = true;
+    }
+    catch(const char* error)
+    {
+        ReportError(error);
+    }
+}
+
+inline void AudioContext::RestoreBuffer(BufferRecord& record)
+{
+    if (!record.source)
+    {
+        return;
+    }
+
+    try
+    {
+        WavData wav = ParseWav(record.source->Load());
+        if (record.loopSet)
+        {
+            wav.loopStart = record.loopStart;
+            wav.loopEnd   = record.loopEnd;
+        }
+        else
+        {
+            record.loopStart = wav.loopStart;
+            record.loopEnd   = wav.loopEnd;
+        }
+        record.name  = UploadBuffer(wav);
+        record.bytes = GetBufferBytes(record.name);
+        m_residentBytes += record.bytes;
+    }
+    catch(const char* error)
+    {
+        ReportError(std::string(error) + " : trying to load " + record.source->GetName());
+    }
+}
+
+// Captures what is playing and releases the context on the device that is going away
+inline void AudioContext::SuspendForReopen(double deviceTime)
+{
+    MakeCurrent();
+
+    m_restoreVoices.clear();
+    for (const Voice& voice : m_voices)
+    {
+        RestoreVoice restore;
+        restore.voice = voice;
+
+        // Sources stop when the device is lost, so carry the last offset seen forward in time
+        if (!voice.paused)
+        {
+            restore.voice.offset += (deviceTime - voice.offsetTime) * voice.frequency * voice.pitch;
+        }
+        restore.voice.offsetTime = deviceTime;
+
+        ALint buffer;
+        alGetSourcei (voice.source, AL_BUFFER,          &buffer);
+        alGetSourcef (voice.source, AL_GAIN,            &restore.gain);
+        alGetSourcef (voice.source, AL_PITCH,           &restore.pitch);
+        alGetSourcefv(voice.source, AL_POSITION,        restore.position);
+        alGetSourcefv(voice.source, AL_VELOCITY,        restore.velocity);
+        alGetSourcei (voice.source, AL_LOOPING,         &restore.looping);
+        alGetSourcei (voice.source, AL_SOURCE_RELATIVE, &restore.relative);
+
+        auto attached = m_sourceBuffers.find(voice.source);
+        restore.buffer = attached != m_sourceBuffers.end() ? attached->second : buffer;
+
+        ALint frames = GetBufferFrames(buffer);
+        ALint loopStart, loopEnd;
+        if (restore.looping && GetLoopPoints(restore.buffer, loopStart, loopEnd))
+        {
+            restore.voice.offset = WrapLoopFrame(restore.voice.offset, loopStart, loopEnd);
+        }
+        else if (restore.looping && frames > 0)
+        {
+            restore.voice.offset = std::fmod(restore.voice.offset, static_cast<double>(frames));
+        }
+        else if (restore.voice.offset >= frames)
+        {
+            continue;
+        }
+        auto sends = m_sourceSlots.find(voice.source);
+        restore.effectSlot = sends != m_sourceSlots.end() ? sends->second : 0;
+        m_restoreVoices.push_back(restore);
+    }
+
+    // Sources die with the context and buffers with the device. Buffers that were resident
+    // are restored on the new device; evicted ones stay evicted.
+    m_pendingBuffers.clear();
+    for (auto& entry : m_bufferRecords)
+    {
+        if (entry.second.name)
+        {
+            m_pendingBuffers.push_back(entry.first);
+        }
+        entry.second.name = 0;
+    }
+    for (auto& entry : m_effectSlots)
+    {
+        entry.second.slot   = 0;
+        entry.second.effect = 0;
+    }
+    m_occlusionFilter = 0;
+    m_voices.clear();
+    m_sources.clear();
+    m_sourceBuffers.clear();
+    m_sourceSlots.clear();
+    m_numSources    = 0;
+    m_numBuffers    = 0;
+    m_residentBytes = 0;
+    DestroyAlContext();
+}
+
+// Recreates the context on the new device and resumes the captured voices. Only buffers those
+// voices need are restored here; Update restores the rest within the restore budget.
+inline void AudioContext::ResumeAfterReopen()
+{
+    CreateAlContext();
+    ++m_generation;
+
+    for (const RestoreVoice& restore : m_restoreVoices)
+    {
+        ALuint buffer = ResolveBuffer(restore.buffer);
+        ALuint source = CreateSource();
+        if (buffer == 0 || source == 0)
+        {
+            continue;
+        }
+
+        alSourcei (source, AL_BUFFER,          buffer);
+        m_sourceBuffers[source] = restore.buffer;
+        alSourcef (source, AL_GAIN,            restore.gain);
+        alSourcef (source, AL_PITCH,           restore.pitch);
+        alSourcefv(source, AL_POSITION,        restore.position);
+        alSourcefv(source, AL_VELOCITY,        restore.velocity);
+        alSourcei (source, AL_LOOPING,         restore.looping);
+        alSourcei (source, AL_SOURCE_RELATIVE, restore.relative);
+        alSourcei (source, AL_SAMPLE_OFFSET,   static_cast<ALint>(restore.voice.offset));
+        BindEffectSlot(source, restore.effectSlot);
+        if (restore.voice.paused)
+        {
+            alSourcePause(source);
+        }
+        else
+        {
+            alSourcePlay(source);
+        }
+
+        Voice voice = restore.voice;
+        voice.occlusionWritten = 0.f;
+        Sound* pSound = voice.pSound;
+        if (pSound && pSound->m_source == voice.source)
+        {
+            pSound->m_source     = source;
+            pSound->m_generation = m_generation;
+        }
+        else
+        {
+            // Overlapped voices go back to the pool once they finish, as before the reopen
+            m_sources.push_back(source);
+        }
+        voice.source = source;
+        m_voices.push_back(voice);
+    }
+    m_restoreVoices.clear();
+}
+
+inline bool AudioDevice::CheckConnection()
+{
+    if (m_pAlDevice == NULL)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return FinishOpen();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_hasDisconnect)
+    {
+        return true;
+    }
+
+    // Another thread may have reopened the device while this one waited for the lock
+    ALCint connected = ALC_TRUE;
+    alcGetIntegerv(m_pAlDevice, ALC_CONNECTED, 1, &connected);
+    if (connected)
+    {
+        return true;
+    }
+
+    double now = GetTime();
+    if (m_lastReopenAttempt > 0.0 && now - m_lastReopenAttempt < m_reopenInterval)
+    {
+        return false;
+    }
+    m_lastReopenAttempt = now;
+    return ReopenDevice();
+}
+
+inline bool AudioDevice::FinishOpen()
+{
+    // The future is only taken once; a thread that waited for the lock sees the result
+    if (m_pAlDevice)
+    {
+        return true;
+    }
+    if (!m_opening.valid() || m_opening.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return false;
+    }
+
+    ALCdevice* pAlDevice = m_opening.get();
+    if (pAlDevice == NULL)
+    {
+        // Nothing will ever play what was queued for the device
+        size_t numDropped = 0;
+        for (AudioContext* pContext : m_contexts)
+        {
+            numDropped += pContext->DropQueuedPlays();
+        }
+        m_isOpening = false;
+
+        std::ostringstream error;
+        error << "Error occurred creating AL device; dropped " << numDropped << " queued plays";
+        ReportError(error.str());
+        return false;
+    }
+
+    m_pAlDevice = pAlDevice;
+    LoadExtensions();
+    for (AudioContext* pContext : m_contexts)
+    {
+        pContext->CreateAlContext();
+    }
+    m_isOpening = false;
+    return true;
+}
+
+inline bool AudioDevice::ReopenDevice()
+{
+    if (m_pAlDevice == NULL || m_pOldDevice)
+    {
+        return false;
+    }
+
+    // Keep the old device until a new one is available so nothing is lost if this fails
+    ALCdevice* pNewDevice = m_loopback ? OpenLoopbackDevice() : alcOpenDevice(m_hasDeviceName ? m_deviceName.c_str() : NULL);
+    if (pNewDevice == NULL)
+    {
+        return false;
+    }
+
+    // Contexts move over in their own updates, on whatever thread drives them
+    m_pOldDevice      = m_pAlDevice;
+    m_pAlDevice       = pNewDevice;
+    m_numPendingMoves = m_contexts.size();
+    LoadExtensions();
+    ++m_deviceGeneration;
+    ++m_numReopens;
+    if (m_numPendingMoves == 0)
+    {
+        alcCloseDevice(m_pOldDevice);
+        m_pOldDevice = NULL;
+    }
+    return true;
+}
+
+inline ALCdevice* AudioDevice::OpenLoopbackDevice()
+{
+    ALCdevice* pAlDevice = OPENAL_CALL(m_alcLoopbackOpenDeviceSOFT, NULL);
+    if (pAlDevice && !OPENAL_CALL(m_alcIsRenderFormatSupportedSOFT, pAlDevice, m_loopbackFormat.frequency, m_loopbackFormat.channels, m_loopbackFormat.type))
+    {
+        alcCloseDevice(pAlDevice);
+        pAlDevice = NULL;
+    }
+    return pAlDevice;
+}
+
+inline void AudioDevice::FinishMove()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_numPendingMoves > 0 && --m_numPendingMoves == 0)
+    {
+        alcCloseDevice(m_pOldDevice);
+        m_pOldDevice = NULL;
+    }
+}
+
+inline ALuint AudioContext::StealSoundSource()
+{
+    std::unordered_set<ALuint> playing;
+    for (const Voice& voice : m_voices)
+    {
+        playing.insert(voice.source);
+    }
+
+    Sound* pVictim = NULL;
+    for (Sound* pSound : m_sounds)
+    {
+        if (pSound->m_source && pSound->m_generation == m_generation && !playing.count(pSound->m_source))
+        {
+            pVictim = pSound;
+            break;
+        }
+    }
+    if (pVictim == NULL)
+    {
+        double oldest = DBL_MAX;
+        for (const Voice& voice : m_voices)
+        {
+            if (voice.pSound && voice.pSound->m_source == voice.source && voice.playTime < oldest)
+            {
+                pVictim = voice.pSound;
+                oldest  = voice.playTime;
+            }
+        }
+        if (pVictim == NULL)
+        {
+            return 0;
+        }
+        ++m_numStolen;
+    }
+
+    ALuint alSource = pVictim->m_source;
+    alSourceStop(alSource);
+    pVictim->m_source = 0;
+    pVictim->m_clock.Reset();
+    return alSource;
+}
+
+inline AudioContext::~AudioContext()
+{
+    // Sources held by sounds are deleted along with the pooled ones
+    std::vector<ALuint> soundSources;
+    for (Sound* pSound : m_sounds)
+    {
+        if (pSound->m_source && pSound->m_generation == m_generation)
+        {
+            soundSources.push_back(pSound->m_source);
+        }
+        pSound->m_pContext = NULL;
+        pSound->m_source   = 0;
+        pSound->m_clock.Reset();
+    }
+
+    if (m_pAlContext == NULL)
+    {
+        return;
+    }
+
+    MakeCurrent();
+
+    // Sources first; a buffer still attached to a source cannot be deleted
+    for (ALuint source : m_sources)
+    {
+        alDeleteSources(1, &source);
+    }
+    for (ALuint source : soundSources)
+    {
+        alDeleteSources(1, &source);
+    }
+
+    for (auto& entry : m_effectSlots)
+    {
+        DeleteEffectSlot(entry.second);
+    }
+    if (m_occlusionFilter)
+    {
+        OPENAL_CALL(m_efx.alDeleteFilters, 1, &m_occlusionFilter);
+    }
+
+    for (auto& entry : m_bufferRecords)
+    {
+        if (entry.second.owned && entry.second.name)
+        {
+            alDeleteBuffers(1, &entry.second.name);
+        }
+    }
+
+    DestroyAlContext();
+}
+
+inline void AudioContext::ForgetSound(Sound* pSound)
+{
+    m_sounds.erase(pSound);
+    CancelScheduled(pSound);
+    m_fades.erase(std::remove_if(m_fades.begin(), m_fades.end(),
+        [pSound](const Fade& fade) { return fade.pSound == pSound; }), m_fades.end());
+    auto emitter = m_soundEmitters.find(pSound);
+    if (emitter != m_soundEmitters.end())
+    {
+        RemoveEmitter(emitter->second);
+    }
+    for (Voice& voice : m_voices)
+    {
+        if (voice.pSound == pSound)
+        {
+            voice.pSound = NULL;
+        }
+    }
+}
+
+inline void AudioContext::Update()
+{
+    auto start = std::chrono::steady_clock::now();
+    unsigned int numCalls = t_numAlCalls;
+    m_alCallsPerFrame = numCalls - m_frameStartCalls;
+    m_frameStartCalls = numCalls;
+
+    Tick();
+
+    m_updateTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    m_updateTimes.Add(m_updateTime);
+}
+
+inline void AudioContext::Tick()
+{
+    // The device was reopened; move onto it here, on the thread that updates this context
+    unsigned int deviceGeneration = m_pDevice->m_deviceGeneration;
+    if (m_deviceGeneration != deviceGeneration)
+    {
+        SuspendForReopen(GetDeviceTime());
+        ResumeAfterReopen();
+        m_deviceGeneration = deviceGeneration;
+        m_pDevice->FinishMove();
+    }
+
+    // Sources all stop when the output goes away, so leave voices alone until it is back
+    if (!m_pDevice->CheckConnection() || !IsValid())
+    {
+        return;
+    }
+    MakeCurrent();
+
+    if (!m_queuedPlays.empty())
+    {
+        // Plays made while the device was opening
+        std::vector<ScheduledPlay> queued;
+        queued.swap(m_queuedPlays);
+        for (const ScheduledPlay& play : queued)
+        {
+            play.pSound->Start(play.overlap, 0.0);
+        }
+    }
+
+    if (!m_pendingBuffers.empty())
+    {
+        // Restore the rest of the buffers from the lost device a slice at a time
+        auto start = std::chrono::steady_clock::now();
+        while (!m_pendingBuffers.empty() &&
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < m_restoreBudget)
+        {
+            auto it = m_bufferRecords.find(m_pendingBuffers.front());
+            if (it != m_bufferRecords.end() && it->second.name == 0)
+            {
+                m_lru.splice(m_lru.end(), m_lru, it->second.lru);
+                RestoreBuffer(it->second);
+                EnforceMemoryBudget(it->first);
+            }
+            m_pendingBuffers.pop_front();
+        }
+    }
+
+    double now = GetDeviceTime();
+    for (size_t i = 0; i < m_voices.size();)
+    {
+        Voice& voice = m_voices[i];
+
+        // Only the most recent voice of a sound drives its playback clock
+        Sound* pClockSound = (voice.pSound && voice.pSound->m_source == voice.source) ? voice.pSound : NULL;
+
+        ALint state;
+        alGetSourcei(voice.source, AL_SOURCE_STATE, &state);
+        if (state != AL_PLAYING && state != AL_PAUSED)
+        {
+            if (pClockSound)
+            {
+                pClockSound->m_clock.Reset();
+            }
+            if (voice.occlusionWritten > 0.f)
+            {
+                // The source goes back to the pool unfiltered
+                alSourcei(voice.source, AL_DIRECT_FILTER, AL_FILTER_NULL);
+            }
+            m_voices[i] = m_voices.back();
+            m_voices.pop_back();
+            continue;
+        }
+
+        double offset;
+        double latency = GetOutputLatency();
+        if (m_alGetSourcei64vSOFT)
+        {
+            // { sample offset in 32.32 fixed point, latency in nanoseconds }
+            ALint64SOFT offsetLatency[2];
+            OPENAL_CALL(m_alGetSourcei64vSOFT, voice.source, AL_SAMPLE_OFFSET_LATENCY_SOFT, offsetLatency);
+            offset = (offsetLatency[0] >> 32) + (offsetLatency[0] & 0xFFFFFFFF) / 4294967296.0;
+            if (state == AL_PLAYING)
+            {
+                latency = offsetLatency[1] * 1.0e-9;
+                m_outputLatency = latency;
+                m_outputLatencies.Add(latency);
+            }
+        }
+        else
+        {
+            ALint sampleOffset;
+            alGetSourcei(voice.source, AL_SAMPLE_OFFSET, &sampleOffset);
+            offset = sampleOffset;
+        }
+
+        voice.offset     = offset;
+        voice.offsetTime = now;
+        voice.paused     = state == AL_PAUSED;
+
+        double framesPerSecond = voice.frequency * voice.pitch;
+        if (state == AL_PLAYING && !voice.heard && offset > voice.startOffset && framesPerSecond > 0.0)
+        {
+            // Work back from the mixer offset to when the mixer started the source
+            double mixStart = now - (offset - voice.startOffset) / framesPerSecond;
+            m_playLatencies.Add(std::max(0.0, mixStart + latency - voice.playTime));
+            voice.heard = true;
+        }
+
+        if (pClockSound)
+        {
+            bool playing = state == AL_PLAYING;
+            pClockSound->PublishClock(now, playing ? offset - latency * framesPerSecond : offset, playing);
+        }
+        ++i;
+    }
+
+    UpdateFades(now);
+    UpdateVelocities(now);
+    UpdateDucking(now);
+    UpdateBuses();
+    UpdateOcclusion(now);
+
+    // Voices that finished may have left buffers that can now be evicted
+    EnforceMemoryBudget(0);
+
+    UpdateReverbZones();
+    UpdateEmitters(now);
+
+    // Advance the monotonic audible clock even when nobody reads it this frame
+    GetAudibleTime();
+
+    if (!m_virtualPlays.empty())
+    {
+        // Virtual voices that came within range start where they would have been by now
+        std::vector<ScheduledPlay> audible;
+        for (size_t i = 0; i < m_virtualPlays.size();)
+        {
+            if (IsAudible(*m_virtualPlays[i].pSound))
+            {
+                audible.push_back(m_virtualPlays[i]);
+                m_virtualPlays[i] = m_virtualPlays.back();
+                m_virtualPlays.pop_back();
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        for (const ScheduledPlay& play : audible)
+        {
+            play.pSound->Start(play.overlap, now - play.deviceTime);
+        }
+    }
+
+    if (m_scheduled.empty())
+    {
+        return;
+    }
+
+    // A source started now is heard after the output latency; anything due by then starts
+    // now, skipping what would already have been heard had it started on time
+    double audibleTime = GetDeviceTime() + GetOutputLatency();
+    std::vector<ScheduledPlay> due;
+    for (size_t i = 0; i < m_scheduled.size();)
+    {
+        if (m_scheduled[i].deviceTime <= audibleTime)
+        {
+            due.push_back(m_scheduled[i]);
+            m_scheduled.erase(m_scheduled.begin() + i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    for (const ScheduledPlay& play : due)
+    {
+        play.pSound->Start(play.overlap, audibleTime - play.deviceTime);
+    }
+}
+
+};  // namespace OpenAL
+
+#include "OpenALCallMacrosEnd.h"
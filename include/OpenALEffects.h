@@ -0,0 +1,167 @@
+#pragma once
+
+// EFX (ALC_EXT_EFX) entry points, and loading the reverb presets of efx-presets.h into effects.
+// Effects are fetched with alGetProcAddress like the other extensions the block uses.
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "AL/efx.h"
+#include "AL/efx-presets.h"
+
+#include "OpenALCalls.h"
+#include "OpenALErrors.h"
+
+#include <algorithm>
+
+#include "OpenALCallMacros.h"
+
+namespace OpenAL
+{
+
+// The EFX functions of a context; all NULL when its device does not support ALC_EXT_EFX
+struct EfxFunctions
+{
+    LPALGENEFFECTS                  alGenEffects;
+    LPALDELETEEFFECTS               alDeleteEffects;
+    LPALEFFECTI                     alEffecti;
+    LPALEFFECTF                     alEffectf;
+    LPALEFFECTFV                    alEffectfv;
+    LPALGETEFFECTI                  alGetEffecti;
+    LPALGENFILTERS                  alGenFilters;
+    LPALDELETEFILTERS               alDeleteFilters;
+    LPALFILTERI                     alFilteri;
+    LPALFILTERF                     alFilterf;
+    LPALGENAUXILIARYEFFECTSLOTS     alGenAuxiliaryEffectSlots;
+    LPALDELETEAUXILIARYEFFECTSLOTS  alDeleteAuxiliaryEffectSlots;
+    LPALAUXILIARYEFFECTSLOTI        alAuxiliaryEffectSloti;
+    LPALAUXILIARYEFFECTSLOTF        alAuxiliaryEffectSlotf;
+    bool                            hasEaxReverb;
+    ALCint                          maxSends;
+
+    EfxFunctions()
+    {
+        Clear();
+    }
+
+    bool IsSupported() const { return alGenAuxiliaryEffectSlots != NULL; }
+
+    void Clear()
+    {
+        alGenEffects                    = NULL;
+        alDeleteEffects                 = NULL;
+        alEffecti                       = NULL;
+        alEffectf                       = NULL;
+        alEffectfv                      = NULL;
+        alGetEffecti                    = NULL;
+        alGenFilters                    = NULL;
+        alDeleteFilters                 = NULL;
+        alFilteri                       = NULL;
+        alFilterf                       = NULL;
+        alGenAuxiliaryEffectSlots       = NULL;
+        alDeleteAuxiliaryEffectSlots    = NULL;
+        alAuxiliaryEffectSloti          = NULL;
+        alAuxiliaryEffectSlotf          = NULL;
+        hasEaxReverb                    = false;
+        maxSends                        = 0;
+    }
+
+    // Call with the context current
+    void Load(ALCdevice* pDevice)
+    {
+        Clear();
+        if (!alcIsExtensionPresent(pDevice, "ALC_EXT_EFX"))
+        {
+            return;
+        }
+
+        alGenEffects                    = reinterpret_cast<LPALGENEFFECTS>(alGetProcAddress("alGenEffects"));
+        alDeleteEffects                 = reinterpret_cast<LPALDELETEEFFECTS>(alGetProcAddress("alDeleteEffects"));
+        alEffecti                       = reinterpret_cast<LPALEFFECTI>(alGetProcAddress("alEffecti"));
+        alEffectf                       = reinterpret_cast<LPALEFFECTF>(alGetProcAddress("alEffectf"));
+        alEffectfv                      = reinterpret_cast<LPALEFFECTFV>(alGetProcAddress("alEffectfv"));
+        alGetEffecti                    = reinterpret_cast<LPALGETEFFECTI>(alGetProcAddress("alGetEffecti"));
+        alGenFilters                    = reinterpret_cast<LPALGENFILTERS>(alGetProcAddress("alGenFilters"));
+        alDeleteFilters                 = reinterpret_cast<LPALDELETEFILTERS>(alGetProcAddress("alDeleteFilters"));
+        alFilteri                       = reinterpret_cast<LPALFILTERI>(alGetProcAddress("alFilteri"));
+        alFilterf                       = reinterpret_cast<LPALFILTERF>(alGetProcAddress("alFilterf"));
+        alGenAuxiliaryEffectSlots       = reinterpret_cast<LPALGENAUXILIARYEFFECTSLOTS>(alGetProcAddress("alGenAuxiliaryEffectSlots"));
+        alDeleteAuxiliaryEffectSlots    = reinterpret_cast<LPALDELETEAUXILIARYEFFECTSLOTS>(alGetProcAddress("alDeleteAuxiliaryEffectSlots"));
+        alAuxiliaryEffectSloti          = reinterpret_cast<LPALAUXILIARYEFFECTSLOTI>(alGetProcAddress("alAuxiliaryEffectSloti"));
+        alAuxiliaryEffectSlotf          = reinterpret_cast<LPALAUXILIARYEFFECTSLOTF>(alGetProcAddress("alAuxiliaryEffectSlotf"));
+        if (!alGenEffects || !alDeleteEffects || !alEffecti || !alEffectf || !alEffectfv || !alGetEffecti ||
+            !alGenFilters || !alDeleteFilters || !alFilteri || !alFilterf ||
+            !alGenAuxiliaryEffectSlots || !alDeleteAuxiliaryEffectSlots || !alAuxiliaryEffectSloti || !alAuxiliaryEffectSlotf)
+        {
+            Clear();
+            return;
+        }
+
+        alcGetIntegerv(pDevice, ALC_MAX_AUXILIARY_SENDS, 1, &maxSends);
+
+        // Presets are EAX reverb properties; without EAX reverb they map onto standard reverb
+        ALuint probe = 0;
+        ALint  type  = AL_EFFECT_NULL;
+        OPENAL_CALL(alGenEffects, 1, &probe);
+        OPENAL_CALL(alEffecti, probe, AL_EFFECT_TYPE, AL_EFFECT_EAXREVERB);
+        OPENAL_CALL(alGetEffecti, probe, AL_EFFECT_TYPE, &type);
+        OPENAL_CALL(alDeleteEffects, 1, &probe);
+        hasEaxReverb = type == AL_EFFECT_EAXREVERB;
+        if (!hasEaxReverb && HasAlError())
+        {
+            ReportError("EAX reverb is not supported, using standard reverb");
+        }
+    }
+};
+
+// Sets up an effect as the reverb described by an EFX_REVERB_PRESET_* preset
+static void LoadReverbPreset(const EfxFunctions& efx, ALuint effect, const EFXEAXREVERBPROPERTIES& preset)
+{
+    if (efx.hasEaxReverb)
+    {
+        OPENAL_CALL(efx.alEffecti,  effect, AL_EFFECT_TYPE,                      AL_EFFECT_EAXREVERB);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_DENSITY,                preset.flDensity);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_DIFFUSION,              preset.flDiffusion);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_GAIN,                   preset.flGain);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_GAINHF,                 preset.flGainHF);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_GAINLF,                 preset.flGainLF);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_DECAY_TIME,             preset.flDecayTime);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_DECAY_HFRATIO,          preset.flDecayHFRatio);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_DECAY_LFRATIO,          preset.flDecayLFRatio);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_REFLECTIONS_GAIN,       preset.flReflectionsGain);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_REFLECTIONS_DELAY,      preset.flReflectionsDelay);
+        OPENAL_CALL(efx.alEffectfv, effect, AL_EAXREVERB_REFLECTIONS_PAN,        preset.flReflectionsPan);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_LATE_REVERB_GAIN,       preset.flLateReverbGain);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_LATE_REVERB_DELAY,      preset.flLateReverbDelay);
+        OPENAL_CALL(efx.alEffectfv, effect, AL_EAXREVERB_LATE_REVERB_PAN,        preset.flLateReverbPan);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_ECHO_TIME,              preset.flEchoTime);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_ECHO_DEPTH,             preset.flEchoDepth);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_MODULATION_TIME,        preset.flModulationTime);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_MODULATION_DEPTH,       preset.flModulationDepth);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_AIR_ABSORPTION_GAINHF,  preset.flAirAbsorptionGainHF);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_HFREFERENCE,            preset.flHFReference);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_LFREFERENCE,            preset.flLFReference);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_EAXREVERB_ROOM_ROLLOFF_FACTOR,    preset.flRoomRolloffFactor);
+        OPENAL_CALL(efx.alEffecti,  effect, AL_EAXREVERB_DECAY_HFLIMIT,          preset.iDecayHFLimit);
+    }
+    else
+    {
+        OPENAL_CALL(efx.alEffecti,  effect, AL_EFFECT_TYPE,                      AL_EFFECT_REVERB);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_DENSITY,                   preset.flDensity);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_DIFFUSION,                 preset.flDiffusion);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_GAIN,                      preset.flGain);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_GAINHF,                    preset.flGainHF);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_DECAY_TIME,                preset.flDecayTime);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_DECAY_HFRATIO,             preset.flDecayHFRatio);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_REFLECTIONS_GAIN,          std::min(preset.flReflectionsGain, AL_REVERB_MAX_REFLECTIONS_GAIN));
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_REFLECTIONS_DELAY,         preset.flReflectionsDelay);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_LATE_REVERB_GAIN,          std::min(preset.flLateReverbGain, AL_REVERB_MAX_LATE_REVERB_GAIN));
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_LATE_REVERB_DELAY,         preset.flLateReverbDelay);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_AIR_ABSORPTION_GAINHF,     preset.flAirAbsorptionGainHF);
+        OPENAL_CALL(efx.alEffectf,  effect, AL_REVERB_ROOM_ROLLOFF_FACTOR,       preset.flRoomRolloffFactor);
+        OPENAL_CALL(efx.alEffecti,  effect, AL_REVERB_DECAY_HFLIMIT,             preset.iDecayHFLimit);
+    }
+}
+
+} // namespace OpenAL
+
+#include "OpenALCallMacrosEnd.h"
@@ -0,0 +1,135 @@
+#pragma once
+
+// A spatial index of emitters: points in the world, each heard within its own radius.
+// Emitters are kept in a uniform grid by the cells their sphere overlaps, so finding the
+// emitters in range of a point looks at one cell however many emitters there are, and moving
+// an emitter only touches the grid when it crosses into different cells. Emitters too large
+// for that to pay off are kept in a short list that every query tests.
+
+#include "OpenALMath.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace OpenAL
+{
+
+class EmitterGrid
+{
+public:
+    EmitterGrid(float cellSize = 32.f) :
+        m_grid(cellSize), m_lastId(0)
+    {
+    }
+
+    unsigned int Add(const Vec3& position, float radius)
+    {
+        unsigned int id = ++m_lastId;
+        Emitter& emitter = m_emitters[id];
+        emitter.position = position;
+        emitter.radius   = radius;
+        Insert(id, emitter);
+        return id;
+    }
+
+    void Remove(unsigned int id)
+    {
+        auto it = m_emitters.find(id);
+        if (it != m_emitters.end())
+        {
+            m_grid.Erase(id, it->second.cells);
+            m_emitters.erase(it);
+        }
+    }
+
+    void Move(unsigned int id, const Vec3& position)
+    {
+        auto it = m_emitters.find(id);
+        if (it != m_emitters.end())
+        {
+            Update(id, it->second, position, it->second.radius);
+        }
+    }
+
+    void SetRadius(unsigned int id, float radius)
+    {
+        auto it = m_emitters.find(id);
+        if (it != m_emitters.end())
+        {
+            Update(id, it->second, it->second.position, radius);
+        }
+    }
+
+    void Clear()
+    {
+        m_emitters.clear();
+        m_grid.Clear();
+    }
+
+    bool    IsEmpty() const { return m_emitters.empty(); }
+    size_t  GetCount() const { return m_emitters.size(); }
+
+    // Rebuilds the index; see UniformGrid::SetCellSize
+    void SetCellSize(float cellSize)
+    {
+        m_grid.SetCellSize(cellSize);
+        for (auto& entry : m_emitters)
+        {
+            Insert(entry.first, entry.second);
+        }
+    }
+
+    // Appends the emitters whose radius reaches the point
+    void Query(const Vec3& point, std::vector<unsigned int>& ids) const
+    {
+        m_grid.ForEachNear(point, [this, &point, &ids](unsigned int id)
+        {
+            const Emitter& emitter = m_emitters.find(id)->second;
+            Vec3 d = point - emitter.position;
+            if (Dot(d, d) <= emitter.radius * emitter.radius)
+            {
+                ids.push_back(id);
+            }
+        });
+    }
+
+private:
+    struct Emitter
+    {
+        Vec3        position;
+        float       radius;
+        GridCells   cells;      // of the sphere's bounds, as inserted
+    };
+
+    UniformGrid<unsigned int>                   m_grid;
+    unsigned int                                m_lastId;
+    std::unordered_map<unsigned int, Emitter>   m_emitters;
+
+    GridCells GetCells(const Vec3& position, float radius) const
+    {
+        Vec3 extent(radius, radius, radius);
+        return m_grid.GetCells(position - extent, position + extent);
+    }
+
+    void Insert(unsigned int id, Emitter& emitter)
+    {
+        emitter.cells = GetCells(emitter.position, emitter.radius);
+        m_grid.Insert(id, emitter.cells);
+    }
+
+    // Most moves stay within the same cells and leave the grid alone
+    void Update(unsigned int id, Emitter& emitter, const Vec3& position, float radius)
+    {
+        GridCells cells = GetCells(position, radius);
+        emitter.position = position;
+        emitter.radius   = radius;
+        if (cells != emitter.cells)
+        {
+            m_grid.Erase(id, emitter.cells);
+            emitter.cells = cells;
+            m_grid.Insert(id, emitter.cells);
+        }
+    }
+};
+
+} // namespace OpenAL
@@ -0,0 +1,103 @@
+#pragma once
+
+// How the block checks for and reports errors.
+//
+// AL errors are only seen by calling alGetError, which takes the context lock, so checking is
+// a policy set with SetErrorPolicy. Its default is chosen when src/OpenAL.cpp is compiled, by
+// OPENAL_CHECK_ERRORS (on unless NDEBUG is defined there). The policy is only read at run
+// time, so translation units built with and without NDEBUG share one HasAlError. Unchecked,
+// the block makes no alGetError calls at all; failures then only show as NULL or 0 results.
+// Errors that do not come from AL, such as a malformed .wav or a device that cannot be
+// opened, are always reported.
+
+#include "OpenALCalls.h"
+
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "OpenALCallMacros.h"
+
+namespace OpenAL
+{
+
+enum ErrorPolicy
+{
+    ErrorPolicyUnchecked,   // never calls alGetError
+    ErrorPolicyChecked      // calls alGetError around AL work and reports what it returns
+};
+
+// Receives a description of the error and the AL error code, AL_NO_ERROR if it did not come from AL
+typedef std::function<void (const std::string& message, ALenum alError)> ErrorCallback;
+
+extern ErrorPolicy          g_errorPolicy;
+extern ErrorCallback        g_errorCallback;
+
+// The most recent AL error seen on the calling thread, and the one the next report is about
+extern OPENAL_THREAD_LOCAL ALenum t_lastAlError;
+extern OPENAL_THREAD_LOCAL ALenum t_unreportedAlError;
+
+// alGetError calls HasAlError has made on the calling thread; wraps around
+extern OPENAL_THREAD_LOCAL unsigned int t_numErrorChecks;
+
+inline void SetErrorPolicy(ErrorPolicy policy)
+{
+    g_errorPolicy = policy;
+}
+
+inline ErrorPolicy GetErrorPolicy()
+{
+    return g_errorPolicy;
+}
+
+// Errors are written to std::cerr unless a callback is set; pass an empty callback to go back to that
+inline void SetErrorCallback(const ErrorCallback& callback)
+{
+    g_errorCallback = callback;
+}
+
+// The most recent AL error on the calling thread, AL_NO_ERROR if there has been none; clears it
+inline ALenum GetLastAlError()
+{
+    ALenum error = t_lastAlError;
+    t_lastAlError = AL_NO_ERROR;
+    return error;
+}
+
+// Checks for a pending AL error under the error policy, remembering it if there is one.
+// Always false when unchecked.
+inline bool HasAlError()
+{
+    if (g_errorPolicy == ErrorPolicyChecked)
+    {
+        ++t_numErrorChecks;
+        ALenum error = alGetError();
+        if (error != AL_NO_ERROR)
+        {
+            t_lastAlError       = error;
+            t_unreportedAlError = error;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Passes an error to the error callback, or writes it to std::cerr, along with the AL error
+// that caused it if it was found by HasAlError
+inline void ReportError(const std::string& message)
+{
+    ALenum alError = t_unreportedAlError;
+    t_unreportedAlError = AL_NO_ERROR;
+    if (g_errorCallback)
+    {
+        g_errorCallback(message, alError);
+    }
+    else
+    {
+        std::cerr << message << std::endl;
+    }
+}
+
+} // namespace OpenAL
+
+#include "OpenALCallMacrosEnd.h"
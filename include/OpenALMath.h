@@ -0,0 +1,203 @@
+#pragma once
+
+// The small amount of vector math the block needs for positions, zones and velocities, and
+// the uniform grid zones and emitters are indexed by
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace OpenAL
+{
+
+// A position, velocity or direction. Converts from any vector type with x, y and z members,
+// such as ci::vec3.
+struct Vec3
+{
+    float x;
+    float y;
+    float z;
+
+    Vec3() : x(0.f), y(0.f), z(0.f) {}
+    Vec3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+
+    template<typename Vector>
+    Vec3(const Vector& v) : x(v.x), y(v.y), z(v.z) {}
+
+    Vec3 operator+(const Vec3& v) const { return Vec3(x + v.x, y + v.y, z + v.z); }
+    Vec3 operator-(const Vec3& v) const { return Vec3(x - v.x, y - v.y, z - v.z); }
+    Vec3 operator*(float s) const       { return Vec3(x * s, y * s, z * s); }
+};
+
+inline float Dot(const Vec3& a, const Vec3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline float Length(const Vec3& v)
+{
+    return std::sqrt(Dot(v, v));
+}
+
+// Cells GetGridKey can tell apart on each side of the origin
+static const int g_maxGridCell = (1 << 20) - 1;
+
+// Entries covering more cells than this are kept out of the grid and tested on every query
+static const double g_maxGridCellsPerEntry = 512.0;
+
+// Cell of a uniform grid a coordinate falls in, clamped to the cells GetGridKey can hash
+inline int GetGridCell(float coordinate, float cellSize)
+{
+    double cell = std::floor(static_cast<double>(coordinate) / cellSize);
+    if (!(cell > -g_maxGridCell))
+    {
+        return -g_maxGridCell;
+    }
+    return cell < g_maxGridCell ? static_cast<int>(cell) : g_maxGridCell;
+}
+
+// Number of cells in the inclusive range [low, high] on each axis
+inline double GetGridCellCount(const int* low, const int* high)
+{
+    double count = 1.0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        count *= static_cast<double>(high[axis]) - low[axis] + 1.0;
+    }
+    return count;
+}
+
+// Hash key of a grid cell, 21 bits per axis
+inline int64_t GetGridKey(int x, int y, int z)
+{
+    const int64_t mask = (1 << 21) - 1;
+    return ((static_cast<int64_t>(x) & mask) << 42) | ((static_cast<int64_t>(y) & mask) << 21) | (static_cast<int64_t>(z) & mask);
+}
+
+// The inclusive range of cells a box overlaps, and whether that is too many to store it in
+struct GridCells
+{
+    int     low[3];
+    int     high[3];
+    bool    oversized;
+
+    bool operator==(const GridCells& cells) const
+    {
+        return std::equal(low, low + 3, cells.low) && std::equal(high, high + 3, cells.high);
+    }
+    bool operator!=(const GridCells& cells) const { return !(*this == cells); }
+};
+
+// Ids of things in the world by the cells of a uniform grid their bounds overlap, so finding
+// what may reach a point looks at one cell however many there are. Entries covering more than
+// g_maxGridCellsPerEntry cells are kept in a short list instead that every lookup returns.
+// The owner keeps each entry's bounds and passes the same GridCells to Insert and Erase.
+template<typename Id>
+class UniformGrid
+{
+public:
+    UniformGrid(float cellSize) :
+        m_cellSize(cellSize)
+    {
+    }
+
+    float GetCellSize() const { return m_cellSize; }
+
+    // Entries much larger than a cell are stored in many cells, up to g_maxGridCellsPerEntry.
+    // Empties the grid; the owner inserts its entries again with their new cells.
+    void SetCellSize(float cellSize)
+    {
+        m_cellSize = cellSize;
+        Clear();
+    }
+
+    void Clear()
+    {
+        m_cells.clear();
+        m_oversized.clear();
+    }
+
+    GridCells GetCells(const Vec3& lowCorner, const Vec3& highCorner) const
+    {
+        GridCells cells;
+        cells.low[0]    = GetGridCell(lowCorner.x, m_cellSize);
+        cells.low[1]    = GetGridCell(lowCorner.y, m_cellSize);
+        cells.low[2]    = GetGridCell(lowCorner.z, m_cellSize);
+        cells.high[0]   = GetGridCell(highCorner.x, m_cellSize);
+        cells.high[1]   = GetGridCell(highCorner.y, m_cellSize);
+        cells.high[2]   = GetGridCell(highCorner.z, m_cellSize);
+        cells.oversized = GetGridCellCount(cells.low, cells.high) > g_maxGridCellsPerEntry;
+        return cells;
+    }
+
+    void Insert(Id id, const GridCells& cells)
+    {
+        if (cells.oversized)
+        {
+            m_oversized.push_back(id);
+            return;
+        }
+        ForEachCell(cells, [this, id](int64_t key) { m_cells[key].push_back(id); });
+    }
+
+    void Erase(Id id, const GridCells& cells)
+    {
+        if (cells.oversized)
+        {
+            m_oversized.erase(std::remove(m_oversized.begin(), m_oversized.end(), id), m_oversized.end());
+            return;
+        }
+        ForEachCell(cells, [this, id](int64_t key)
+        {
+            std::vector<Id>& cell = m_cells[key];
+            cell.erase(std::remove(cell.begin(), cell.end(), id), cell.end());
+            if (cell.empty())
+            {
+                m_cells.erase(key);
+            }
+        });
+    }
+
+    // Calls function with every id whose cells hold the point, and every oversized one; the
+    // caller tests each against its actual bounds
+    template<typename Function>
+    void ForEachNear(const Vec3& point, Function function) const
+    {
+        for (Id id : m_oversized)
+        {
+            function(id);
+        }
+        auto cell = m_cells.find(GetGridKey(GetGridCell(point.x, m_cellSize), GetGridCell(point.y, m_cellSize), GetGridCell(point.z, m_cellSize)));
+        if (cell != m_cells.end())
+        {
+            for (Id id : cell->second)
+            {
+                function(id);
+            }
+        }
+    }
+
+private:
+    float                                       m_cellSize;
+    std::unordered_map<int64_t, std::vector<Id>> m_cells;
+    std::vector<Id>                             m_oversized;
+
+    template<typename Function>
+    static void ForEachCell(const GridCells& cells, Function function)
+    {
+        for (int x = cells.low[0]; x <= cells.high[0]; ++x)
+        {
+            for (int y = cells.low[1]; y <= cells.high[1]; ++y)
+            {
+                for (int z = cells.low[2]; z <= cells.high[2]; ++z)
+                {
+                    function(GetGridKey(x, y, z));
+                }
+            }
+        }
+    }
+};
+
+} // namespace OpenAL
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace OpenAL
+{
+
+// Keeps the most recent samples of a measurement in a fixed size ring
+class RollingStats
+{
+public:
+    RollingStats(size_t capacity = 256) :
+        m_samples(capacity), m_next(0), m_count(0)
+    {
+    }
+
+    void Add(double value)
+    {
+        m_samples[m_next] = value;
+        m_next = (m_next + 1) % m_samples.size();
+        m_count = std::min(m_count + 1, m_samples.size());
+    }
+
+    void Clear()
+    {
+        m_next  = 0;
+        m_count = 0;
+    }
+
+    size_t GetCount() const { return m_count; }
+
+    double GetMin() const
+    {
+        return m_count ? *std::min_element(m_samples.begin(), m_samples.begin() + m_count) : 0.0;
+    }
+
+    double GetMax() const
+    {
+        return m_count ? *std::max_element(m_samples.begin(), m_samples.begin() + m_count) : 0.0;
+    }
+
+    double GetAverage() const
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < m_count; ++i)
+        {
+            sum += m_samples[i];
+        }
+        return m_count ? sum / m_count : 0.0;
+    }
+
+    // percentile in [0, 1]
+    double GetPercentile(double percentile) const
+    {
+        if (m_count == 0)
+        {
+            return 0.0;
+        }
+        std::vector<double> sorted(m_samples.begin(), m_samples.begin() + m_count);
+        size_t rank = std::min(static_cast<size_t>(percentile * m_count), m_count - 1);
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+
+private:
+    std::vector<double> m_samples;
+    size_t              m_next;
+    size_t              m_count;
+};
+
+// Latency of the output path in seconds over the most recent samples
+struct LatencyStats
+{
+    // Mixer to speaker latency sampled from active sources with AL_SAMPLE_OFFSET_LATENCY_SOFT
+    double  minOutput;
+    double  avgOutput;
+    double  p99Output;
+    size_t  numOutputSamples;
+
+    // Time from Sound::Play being called until its first sample is heard
+    double  minPlayToAudible;
+    double  avgPlayToAudible;
+    double  p99PlayToAudible;
+    size_t  numPlayToAudibleSamples;
+};
+
+// Snapshot of a context's voices, buffers and frame cost, from AudioContext::GetStats
+struct AudioStats
+{
+    // Voices as of the last update
+    unsigned int    activeVoices;       // sources playing or paused
+    unsigned int    virtualVoices;      // plays waiting to start, or culled looping sounds, that hold no source
+    unsigned int    culledPlays;        // plays found inaudible before taking a source, in total
+    unsigned int    freeVoices;         // sources created but not playing anything
+    unsigned int    stolenVoices;       // cut short to reuse their source, in total
+
+    unsigned int    numSources;
+    unsigned int    numBuffers;
+
+    // Plays that found their buffer resident, and that had to load it; restores after a
+    // reopen and ResolveBuffer calls are not counted
+    unsigned int    bufferHits;
+    unsigned int    bufferMisses;
+    size_t          residentBytes;      // PCM held by the context's buffers
+    unsigned int    bufferEvictions;    // buffers evicted to stay within the memory budget
+
+    // AL and ALC calls made on the updating thread between the last two updates
+    unsigned int    alCallsPerFrame;
+
+    // Voices the occlusion query was asked about in the last update
+    unsigned int    occlusionRays;
+
+    // Emitters registered with AudioContext::AddEmitter, and those the listener is within range of
+    unsigned int    numEmitters;
+    unsigned int    emittersInRange;
+
+    // Seconds spent in Update: the last call, and the average and worst over recent calls
+    double          updateTime;
+    double          avgUpdateTime;
+    double          maxUpdateTime;
+};
+
+} // namespace OpenAL
@@ -0,0 +1,264 @@
+#pragma once
+
+// Where the block gets .wav data from, and the .wav parser. Independent of Cinder; the Cinder
+// adapter in OpenAL.h reads through ci::DataSource.
+
+#include "AL/al.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OpenAL
+{
+
+// A run of bytes the caller owns
+struct DataSpan
+{
+    const void* pData;
+    size_t      size;
+};
+
+// The bytes of a .wav file. Load may be called again whenever a buffer has to be rebuilt,
+// and what it returns must stay valid until the next call or until the source is destroyed.
+class WavSource
+{
+public:
+    virtual ~WavSource() {}
+
+    virtual DataSpan    Load() = 0;
+
+    // Used in error messages
+    virtual std::string GetName() const = 0;
+};
+
+typedef std::shared_ptr<WavSource> WavSourceRef;
+
+// A .wav in memory; the data is copied
+class MemoryWavSource : public WavSource
+{
+public:
+    MemoryWavSource(const void* pData, size_t size, const std::string& name = "memory") :
+        m_data(static_cast<const char*>(pData), static_cast<const char*>(pData) + size), m_name(name)
+    {
+    }
+
+    DataSpan Load()
+    {
+        DataSpan span = { m_data.empty() ? NULL : &m_data[0], m_data.size() };
+        return span;
+    }
+
+    std::string GetName() const { return m_name; }
+
+private:
+    std::vector<char>   m_data;
+    std::string         m_name;
+};
+
+// A .wav file, read the first time it is loaded and kept in memory after that
+class FileWavSource : public WavSource
+{
+public:
+    FileWavSource(const std::string& path) :
+        m_path(path)
+    {
+    }
+
+    DataSpan Load()
+    {
+        if (m_data.empty())
+        {
+            std::ifstream file(m_path.c_str(), std::ios::binary);
+            m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        DataSpan span = { m_data.empty() ? NULL : &m_data[0], m_data.size() };
+        return span;
+    }
+
+    std::string GetName() const { return m_path; }
+
+private:
+    std::string         m_path;
+    std::vector<char>   m_data;
+};
+
+// How a type is turned into a WavSourceRef by the constructors and functions that accept any
+// source. Anything convertible to WavSourceRef works as is; adapters specialize this for their
+// own data source types.
+template<typename Source, typename Enable = void>
+struct WavSourceTraits
+{
+    static WavSourceRef Make(const Source& source) { return source; }
+};
+
+// PCM samples of a parsed .wav, pointing into the data they were parsed from
+struct WavData
+{
+    ALenum      format;
+    ALsizei     frequency;
+    const char* pData;
+    ALsizei     size;
+    ALint       loopStart;  // sample frames of the first loop in a smpl chunk, end exclusive;
+    ALint       loopEnd;    // both 0 without one
+};
+
+// Parses an in-memory .wav; throws a description of the problem (const char*) on failure.
+// Chunks other than fmt, data and smpl are skipped. Fields are little endian, as is the host.
+static WavData ParseWav(const DataSpan& span)
+{
+    const char* pBytes = static_cast<const char*>(span.pData);
+    size_t      size   = span.size;
+
+    auto read16 = [pBytes](size_t offset) { uint16_t value; memcpy(&value, pBytes + offset, sizeof(value)); return value; };
+    auto read32 = [pBytes](size_t offset) { uint32_t value; memcpy(&value, pBytes + offset, sizeof(value)); return value; };
+
+    // Check for RIFF and WAVE tag in memory
+    if (pBytes == NULL || size < 12 || memcmp(pBytes, "RIFF", 4) != 0 || memcmp(pBytes + 8, "WAVE", 4) != 0)
+    {
+        throw ("Invalid RIFF or WAVE Header");
+    }
+
+    uint16_t    numChannels   = 0;
+    uint16_t    bitsPerSample = 0;
+    uint32_t    sampleRate    = 0;
+    const char* pData         = NULL;
+    uint32_t    dataSize      = 0;
+    uint32_t    loopStart     = 0;
+    uint32_t    loopEnd       = 0;
+
+    // Each chunk is a 4 byte id and a 32 bit size, padded to an even length
+    for (size_t offset = 12; offset + 8 <= size;)
+    {
+        const char* pId       = pBytes + offset;
+        uint32_t    chunkSize = read32(offset + 4);
+        size_t      body      = offset + 8;
+        if (chunkSize > size - body)
+        {
+            throw ("Buffer size different than reported size");
+        }
+
+        if (memcmp(pId, "fmt ", 4) == 0)
+        {
+            if (chunkSize < 16)
+            {
+                throw ("Invalid Wave Format");
+            }
+            numChannels   = read16(body + 2);
+            sampleRate    = read32(body + 4);
+            bitsPerSample = read16(body + 14);
+        }
+        else if (memcmp(pId, "data", 4) == 0)
+        {
+            pData    = pBytes + body;
+            dataSize = chunkSize;
+        }
+        else if (memcmp(pId, "smpl", 4) == 0 && chunkSize >= 36 + 24 && read32(body + 28) > 0)
+        {
+            // 36 bytes of sampler fields, then 24 byte loops whose start and end frames are
+            // at 8 and 12; the end frame is played, so it is inclusive
+            loopStart = read32(body + 36 + 8);
+            loopEnd   = read32(body + 36 + 12) + 1;
+        }
+
+        offset = body + chunkSize + (chunkSize & 1);
+    }
+
+    if (sampleRate == 0)
+    {
+        throw ("Invalid Wave Format");
+    }
+    if (pData == NULL)
+    {
+        throw ("Invalid data header");
+    }
+
+    ALenum format = AL_NONE;
+    // The format is worked out by looking at the number of
+    // Channels and the bits per sample.
+    if (numChannels == 1)
+    {
+        if (bitsPerSample == 8)
+        {
+            format = AL_FORMAT_MONO8;
+        }
+        else if (bitsPerSample == 16)
+        {
+            format = AL_FORMAT_MONO16;
+        }
+    }
+    else if (numChannels == 2)
+    {
+        if (bitsPerSample == 8)
+        {
+            format = AL_FORMAT_STEREO8;
+        }
+        else if (bitsPerSample == 16)
+        {
+            format = AL_FORMAT_STEREO16;
+        }
+    }
+
+    if (format == AL_NONE)
+    {
+        throw ("Unsupported channel count or bits per sample");
+    }
+
+    // Loops that do not fit in the data are ignored rather than failing the load
+    uint32_t frames = dataSize / (numChannels * (bitsPerSample / 8));
+    if (loopStart >= loopEnd || loopEnd > frames)
+    {
+        loopStart = 0;
+        loopEnd   = 0;
+    }
+
+    WavData wav = { format, static_cast<ALsizei>(sampleRate), pData, static_cast<ALsizei>(dataSize),
+                    static_cast<ALint>(loopStart), static_cast<ALint>(loopEnd) };
+    return wav;
+}
+
+// Writes a PCM .wav of frames of silence that ParseWav reads back, with a smpl chunk looping
+// [loopStart, loopEnd) when loopEnd is past loopStart. For tests, benchmarks and placeholders.
+static std::vector<char> WriteWav(int channels, int bitsPerSample, int frames, int sampleRate = 44100, uint32_t loopStart = 0, uint32_t loopEnd = 0)
+{
+    uint32_t blockAlign = channels * (bitsPerSample / 8);
+    uint32_t dataSize   = frames * blockAlign;
+    uint32_t smplSize   = loopEnd > loopStart ? 36 + 24 : 0;
+    std::vector<char> wav(44 + dataSize + (smplSize ? 8 + smplSize : 0), 0);
+    char* p = &wav[0];
+
+    auto put16 = [p](size_t offset, uint16_t value) { memcpy(p + offset, &value, sizeof(value)); };
+    auto put32 = [p](size_t offset, uint32_t value) { memcpy(p + offset, &value, sizeof(value)); };
+
+    memcpy(p,      "RIFF", 4);
+    put32(4,       static_cast<uint32_t>(wav.size() - 8));
+    memcpy(p + 8,  "WAVE", 4);
+    memcpy(p + 12, "fmt ", 4);
+    put32(16,      16);
+    put16(20,      1);
+    put16(22,      static_cast<uint16_t>(channels));
+    put32(24,      sampleRate);
+    put32(28,      sampleRate * blockAlign);
+    put16(32,      static_cast<uint16_t>(blockAlign));
+    put16(34,      static_cast<uint16_t>(bitsPerSample));
+    memcpy(p + 36, "data", 4);
+    put32(40,      dataSize);
+
+    if (smplSize)
+    {
+        // One loop; the chunk stores its end frame inclusive
+        size_t smpl = 44 + dataSize;
+        memcpy(p + smpl, "smpl", 4);
+        put32(smpl + 4,           smplSize);
+        put32(smpl + 8 + 28,      1);
+        put32(smpl + 8 + 36 + 8,  loopStart);
+        put32(smpl + 8 + 36 + 12, loopEnd - 1);
+    }
+    return wav;
+}
+
+} // namespace OpenAL
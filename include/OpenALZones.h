@@ -0,0 +1,272 @@
+#pragma once
+
+// Reverb zones: boxes and spheres in world space, each with an efx-presets.h reverb preset.
+// The presets of the zones around a point are blended by how far inside each zone it is.
+// Zones are kept in a uniform grid so a lookup only tests the few zones near the point; zones
+// too large for the grid are kept in a short list that every lookup tests.
+
+#include "AL/efx-presets.h"
+
+#include "OpenALMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+namespace OpenAL
+{
+
+enum ZoneShape
+{
+    ZoneShapeBox,
+    ZoneShapeSphere
+};
+
+struct ReverbZone
+{
+    ZoneShape               shape;
+    Vec3                    center;
+    Vec3                    halfExtents;    // of a box
+    float                   radius;         // of a sphere
+    float                   fade;           // distance inside the edge over which the zone blends in, 0 for a hard edge
+    int                     priority;       // zones nested inside others take precedence with a higher priority
+    EFXEAXREVERBPROPERTIES  preset;
+
+    static ReverbZone Box(const Vec3& center, const Vec3& halfExtents, const EFXEAXREVERBPROPERTIES& preset, float fade = 0.f, int priority = 0)
+    {
+        ReverbZone zone = { ZoneShapeBox, center, halfExtents, 0.f, fade, priority, preset };
+        return zone;
+    }
+
+    static ReverbZone Sphere(const Vec3& center, float radius, const EFXEAXREVERBPROPERTIES& preset, float fade = 0.f, int priority = 0)
+    {
+        ReverbZone zone = { ZoneShapeSphere, center, Vec3(radius, radius, radius), radius, fade, priority, preset };
+        return zone;
+    }
+
+    // How far inside the zone a point is, negative outside
+    float GetDepth(const Vec3& point) const
+    {
+        if (shape == ZoneShapeSphere)
+        {
+            return radius - Length(point - center);
+        }
+        Vec3 d = point - center;
+        return std::min(halfExtents.x - std::fabs(d.x), std::min(halfExtents.y - std::fabs(d.y), halfExtents.z - std::fabs(d.z)));
+    }
+
+    // 0 outside, rising to 1 once the point is fade inside the edge
+    float GetWeight(const Vec3& point) const
+    {
+        float depth = GetDepth(point);
+        if (depth < 0.f)
+        {
+            return 0.f;
+        }
+        return fade > 0.f ? std::min(1.f, depth / fade) : 1.f;
+    }
+};
+
+// The float fields of a preset, for blending and comparing them one by one
+static float EFXEAXREVERBPROPERTIES::* const g_reverbFields[] =
+{
+    &EFXEAXREVERBPROPERTIES::flDensity,         &EFXEAXREVERBPROPERTIES::flDiffusion,
+    &EFXEAXREVERBPROPERTIES::flGain,            &EFXEAXREVERBPROPERTIES::flGainHF,
+    &EFXEAXREVERBPROPERTIES::flGainLF,          &EFXEAXREVERBPROPERTIES::flDecayTime,
+    &EFXEAXREVERBPROPERTIES::flDecayHFRatio,    &EFXEAXREVERBPROPERTIES::flDecayLFRatio,
+    &EFXEAXREVERBPROPERTIES::flReflectionsGain, &EFXEAXREVERBPROPERTIES::flReflectionsDelay,
+    &EFXEAXREVERBPROPERTIES::flLateReverbGain,  &EFXEAXREVERBPROPERTIES::flLateReverbDelay,
+    &EFXEAXREVERBPROPERTIES::flEchoTime,        &EFXEAXREVERBPROPERTIES::flEchoDepth,
+    &EFXEAXREVERBPROPERTIES::flModulationTime,  &EFXEAXREVERBPROPERTIES::flModulationDepth,
+    &EFXEAXREVERBPROPERTIES::flAirAbsorptionGainHF,
+    &EFXEAXREVERBPROPERTIES::flHFReference,     &EFXEAXREVERBPROPERTIES::flLFReference,
+    &EFXEAXREVERBPROPERTIES::flRoomRolloffFactor
+};
+
+// Weighted sum of presets; weights should add up to 1. The decay HF limit, being a switch,
+// comes from the preset with the most weight.
+static EFXEAXREVERBPROPERTIES BlendReverbPresets(const std::vector<const EFXEAXREVERBPROPERTIES*>& presets, const std::vector<float>& weights)
+{
+    EFXEAXREVERBPROPERTIES blend = EFX_REVERB_PRESET_GENERIC;
+    for (auto field : g_reverbFields)
+    {
+        blend.*field = 0.f;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        blend.flReflectionsPan[i] = 0.f;
+        blend.flLateReverbPan[i]  = 0.f;
+    }
+
+    float heaviest = -1.f;
+    for (size_t p = 0; p < presets.size(); ++p)
+    {
+        const EFXEAXREVERBPROPERTIES& preset = *presets[p];
+        float weight = weights[p];
+        for (auto field : g_reverbFields)
+        {
+            blend.*field += preset.*field * weight;
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            blend.flReflectionsPan[i] += preset.flReflectionsPan[i] * weight;
+            blend.flLateReverbPan[i]  += preset.flLateReverbPan[i]  * weight;
+        }
+        if (weight > heaviest)
+        {
+            heaviest            = weight;
+            blend.iDecayHFLimit = preset.iDecayHFLimit;
+        }
+    }
+    return blend;
+}
+
+// True if any field differs by more than tolerance, relative to its size
+static bool ReverbPresetsDiffer(const EFXEAXREVERBPROPERTIES& a, const EFXEAXREVERBPROPERTIES& b, float tolerance = 1.0e-4f)
+{
+    auto differ = [tolerance](float x, float y) { return std::fabs(x - y) > tolerance * std::max(1.f, std::max(std::fabs(x), std::fabs(y))); };
+    for (auto field : g_reverbFields)
+    {
+        if (differ(a.*field, b.*field))
+        {
+            return true;
+        }
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        if (differ(a.flReflectionsPan[i], b.flReflectionsPan[i]) || differ(a.flLateReverbPan[i], b.flLateReverbPan[i]))
+        {
+            return true;
+        }
+    }
+    return a.iDecayHFLimit != b.iDecayHFLimit;
+}
+
+// Zones by id, indexed by the grid cells their bounds overlap
+class ReverbZoneSet
+{
+public:
+    ReverbZoneSet(float cellSize = 16.f) :
+        m_grid(cellSize), m_lastId(0)
+    {
+    }
+
+    unsigned int Add(const ReverbZone& zone)
+    {
+        unsigned int id = ++m_lastId;
+        m_zones[id] = zone;
+        m_grid.Insert(id, GetCells(zone));
+        return id;
+    }
+
+    void Remove(unsigned int id)
+    {
+        auto it = m_zones.find(id);
+        if (it == m_zones.end())
+        {
+            return;
+        }
+
+        m_grid.Erase(id, GetCells(it->second));
+        m_zones.erase(it);
+    }
+
+    void Clear()
+    {
+        m_zones.clear();
+        m_grid.Clear();
+    }
+
+    bool    IsEmpty() const { return m_zones.empty(); }
+    size_t  GetCount() const { return m_zones.size(); }
+
+    // Rebuilds the index; see UniformGrid::SetCellSize
+    void SetCellSize(float cellSize)
+    {
+        m_grid.SetCellSize(cellSize);
+        for (const auto& entry : m_zones)
+        {
+            m_grid.Insert(entry.first, GetCells(entry.second));
+        }
+    }
+
+    // The preset heard at a point. Priorities are layered from the highest down, and whatever
+    // remains goes to the outside preset. Zones of one priority share a tier: the tier covers
+    // the sum of their weights, up to 1, of what is left, split between them in proportion to
+    // their weights, so the order they were added in does not matter. Zones that meet at the
+    // same priority should overlap by their fade distance, so their weights add up to 1 across
+    // the seam and the outside does not leak in between them.
+    EFXEAXREVERBPROPERTIES Evaluate(const Vec3& point, const EFXEAXREVERBPROPERTIES& outside) const
+    {
+        m_found.clear();
+        m_grid.ForEachNear(point, [this, &point](unsigned int id)
+        {
+            const ReverbZone& zone = m_zones.find(id)->second;
+            float weight = zone.GetWeight(point);
+            if (weight > 0.f)
+            {
+                Found found = { &zone, id, weight };
+                m_found.push_back(found);
+            }
+        });
+        if (m_found.empty())
+        {
+            return outside;
+        }
+
+        std::sort(m_found.begin(), m_found.end(), [](const Found& a, const Found& b)
+        {
+            return a.pZone->priority != b.pZone->priority ? a.pZone->priority > b.pZone->priority : a.id < b.id;
+        });
+
+        m_presets.clear();
+        m_weights.clear();
+        float remaining = 1.f;
+        for (size_t first = 0; first < m_found.size();)
+        {
+            size_t end = first;
+            float  sum = 0.f;
+            for (; end < m_found.size() && m_found[end].pZone->priority == m_found[first].pZone->priority; ++end)
+            {
+                sum += m_found[end].weight;
+            }
+
+            float coverage = std::min(1.f, sum);
+            for (size_t f = first; f < end; ++f)
+            {
+                m_presets.push_back(&m_found[f].pZone->preset);
+                m_weights.push_back(remaining * coverage * m_found[f].weight / sum);
+            }
+            remaining *= 1.f - coverage;
+            first = end;
+        }
+        m_presets.push_back(&outside);
+        m_weights.push_back(remaining);
+        return BlendReverbPresets(m_presets, m_weights);
+    }
+
+private:
+    struct Found
+    {
+        const ReverbZone*   pZone;
+        unsigned int        id;
+        float               weight;
+    };
+
+    UniformGrid<unsigned int>                       m_grid;
+    unsigned int                                    m_lastId;
+    std::unordered_map<unsigned int, ReverbZone>    m_zones;
+
+    // Scratch space reused by every lookup
+    mutable std::vector<Found>                          m_found;
+    mutable std::vector<const EFXEAXREVERBPROPERTIES*>  m_presets;
+    mutable std::vector<float>                          m_weights;
+
+    GridCells GetCells(const ReverbZone& zone) const
+    {
+        return m_grid.GetCells(zone.center - zone.halfExtents, zone.center + zone.halfExtents);
+    }
+};
+
+} // namespace OpenAL
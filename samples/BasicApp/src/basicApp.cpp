@@ -18,6 +18,7 @@ class BasicApp : public App{
     void shutdown();
     void mouseDown( MouseEvent event );
 	void keyDown( KeyEvent event );
+	void update();
 	void draw();
 
     // The sound effect source to be played
@@ -95,6 +96,12 @@ void BasicApp::keyDown( KeyEvent event )
     }
 }
 
+void BasicApp::update()
+{
+    // Starts scheduled sounds and refreshes the measured output latency
+    OpenAL::UpdateOpenAL();
+}
+
 void BasicApp::draw()
 {
 	gl::clear( Color( 0.1f, 0.1f, 0.15f ) );
@@ -0,0 +1,527 @@
+// Headless benchmarks for the OpenAL block's hot paths.
+//
+// Every benchmark runs on an ALC_SOFT_loopback device, so no audio hardware is needed and
+// nothing is mixed unless a benchmark asks for it. Results are written as JSON to stdout,
+// or to the file given as the last argument, for comparison between builds. It is built as
+// the OpenALBenchmark target of CMakeLists.txt and needs only OpenALCore, not Cinder.
+//
+//   benchmark [output.json]                        hot path benchmarks
+//   benchmark --stress [options] [output.json]     voice churn stress run
+//       --rate N            one-shot plays per second (default 4000)
+//       --seconds N         rendered seconds to run for (default 10)
+//       --sounds N          distinct sounds to cycle through (default 64)
+//       --max-sources N     source cap before voices are stolen (default 256, 0 for none)
+//   --trace trace.json    writes the AL calls of the run as a Chrome trace; needs a build
+//                         with OPENAL_TRACE_CALLS defined
+
+#include "OpenALCore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+double SecondsSince(const Clock::time_point& start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// An in-memory PCM .wav of silence
+OpenAL::WavSourceRef MakeWav(int channels, int bitsPerSample, int frames, int sampleRate = 44100)
+{
+    std::vector<char> wav = OpenAL::WriteWav(channels, bitsPerSample, frames, sampleRate);
+    return std::make_shared<OpenAL::MemoryWavSource>(&wav[0], wav.size());
+}
+
+// A loopback device with one context that allows more sources than OpenAL Soft's default
+struct Engine
+{
+    OpenAL::AudioDevice*    pDevice;
+    OpenAL::AudioContext*   pContext;
+
+    Engine()
+    {
+        OpenAL::LoopbackFormat format = { 44100, ALC_STEREO_SOFT, ALC_SHORT_SOFT };
+        ALCint attributes[] = { ALC_MONO_SOURCES, 4096, ALC_STEREO_SOURCES, 256, 0 };
+        pDevice  = new OpenAL::AudioDevice(format);
+        pContext = pDevice->CreateContext(attributes);
+    }
+
+    ~Engine()
+    {
+        delete pDevice;
+    }
+
+    bool IsValid() const { return pContext != NULL; }
+};
+
+class JsonWriter
+{
+public:
+    JsonWriter() : m_first(true)
+    {
+        m_out << "{\n  \"benchmarks\": [";
+    }
+
+    // One result row; values are written in the order given
+    void Add(const std::string& name, const std::vector<std::pair<std::string, double> >& values)
+    {
+        m_out << (m_first ? "\n" : ",\n") << "    { \"name\": \"" << name << "\"";
+        for (const auto& value : values)
+        {
+            m_out << ", \"" << value.first << "\": " << value.second;
+        }
+        m_out << " }";
+        m_first = false;
+    }
+
+    std::string Finish()
+    {
+        m_out << "\n  ]\n}\n";
+        return m_out.str();
+    }
+
+private:
+    std::ostringstream  m_out;
+    bool                m_first;
+};
+
+// Cost of Sound::Play when every pooled source is busy, so each call scans the whole pool
+void BenchPlay(JsonWriter& json)
+{
+    const int poolSizes[] = { 0, 16, 64, 256, 1024 };
+    const int plays = 64;
+
+    for (int poolSize : poolSizes)
+    {
+        Engine engine;
+        if (!engine.IsValid())
+        {
+            return;
+        }
+
+        ALuint buffer = engine.pContext->CreateBuffer(MakeWav(1, 16, 4410));
+        engine.pContext->RegisterBuffer(buffer);
+
+        // Overlapping plays of a looping sound hand still playing sources back to the pool
+        OpenAL::Sound filler(buffer, engine.pContext);
+        filler.m_looping = true;
+        for (int i = 0; i <= poolSize; ++i)
+        {
+            filler.Play();
+        }
+
+        OpenAL::Sound sound(buffer, engine.pContext);
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < plays; ++i)
+        {
+            sound.Play();
+        }
+        double seconds = SecondsSince(start);
+
+        json.Add("play", { { "pool_size", poolSize }, { "calls", plays }, { "ns_per_call", seconds * 1.0e9 / plays } });
+    }
+}
+
+// Cost of finding a free source when it is the last one in the pool
+void BenchGetSource(JsonWriter& json)
+{
+    const int poolSizes[] = { 1, 16, 64, 256, 1024 };
+    const int acquires = 1000;
+
+    for (int poolSize : poolSizes)
+    {
+        Engine engine;
+        if (!engine.IsValid())
+        {
+            return;
+        }
+
+        ALuint buffer = engine.pContext->CreateBuffer(MakeWav(1, 16, 4410));
+        engine.pContext->RegisterBuffer(buffer);
+
+        OpenAL::Sound filler(buffer, engine.pContext);
+        filler.m_looping = true;
+        for (int i = 0; i < poolSize; ++i)
+        {
+            filler.Play();
+        }
+        filler.Stop();
+
+        // The stopped source goes back at the end, behind every busy one
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < acquires; ++i)
+        {
+            engine.pContext->ReleaseSource(engine.pContext->AcquireSource());
+        }
+        double seconds = SecondsSince(start);
+
+        json.Add("get_source", { { "pool_size", poolSize }, { "calls", acquires }, { "ns_per_call", seconds * 1.0e9 / acquires } });
+    }
+}
+
+// Parse and upload throughput of CreateBuffer for each PCM format
+void BenchCreateBuffer(JsonWriter& json)
+{
+    struct Format
+    {
+        const char* name;
+        int         channels;
+        int         bits;
+    };
+    const Format formats[] = { { "mono8", 1, 8 }, { "mono16", 1, 16 }, { "stereo8", 2, 8 }, { "stereo16", 2, 16 } };
+    const int frames = 44100 * 5;
+    const int loads  = 20;
+
+    Engine engine;
+    if (!engine.IsValid())
+    {
+        return;
+    }
+
+    for (const Format& format : formats)
+    {
+        OpenAL::WavSourceRef wav = MakeWav(format.channels, format.bits, frames);
+        double bytes = static_cast<double>(frames) * format.channels * (format.bits / 8);
+
+        double seconds = 0.0;
+        for (int i = 0; i < loads; ++i)
+        {
+            Clock::time_point start = Clock::now();
+            ALuint buffer = engine.pContext->CreateBuffer(wav);
+            seconds += SecondsSince(start);
+            engine.pContext->DestroyBuffer(buffer);
+        }
+
+        json.Add(std::string("create_buffer_") + format.name,
+            { { "bytes", bytes }, { "calls", loads }, { "mb_per_s", bytes * loads / seconds / (1024.0 * 1024.0) } });
+    }
+}
+
+// Cost of AudioContext::Update against the number of live voices
+void BenchUpdate(JsonWriter& json)
+{
+    const int voiceCounts[] = { 0, 16, 64, 256, 1024 };
+    const int updates = 200;
+
+    for (int voiceCount : voiceCounts)
+    {
+        Engine engine;
+        if (!engine.IsValid())
+        {
+            return;
+        }
+
+        ALuint buffer = engine.pContext->CreateBuffer(MakeWav(1, 16, 4410));
+        engine.pContext->RegisterBuffer(buffer);
+
+        OpenAL::Sound sound(buffer, engine.pContext);
+        sound.m_looping = true;
+        for (int i = 0; i < voiceCount; ++i)
+        {
+            sound.Play();
+        }
+
+        std::vector<char> block(256 * engine.pDevice->GetFrameSize());
+        double seconds = 0.0;
+        for (int i = 0; i < updates; ++i)
+        {
+            // Advance the mixer between ticks as a real frame would
+            engine.pDevice->Render(&block[0], 256);
+
+            Clock::time_point start = Clock::now();
+            engine.pContext->Update();
+            seconds += SecondsSince(start);
+        }
+
+        json.Add("update", { { "voices", voiceCount }, { "calls", updates }, { "us_per_call", seconds * 1.0e6 / updates } });
+    }
+}
+
+// Cost of finding and blending the reverb zones at a point against the number of zones, laid
+// out on a square of rooms 20 m apart with a box or sphere in each, as a level's would be
+void BenchZoneLookup(JsonWriter& json)
+{
+    const int zoneCounts[] = { 25, 100, 400, 1600 };
+    const int lookups = 200000;
+    const EFXEAXREVERBPROPERTIES room    = EFX_REVERB_PRESET_ROOM;
+    const EFXEAXREVERBPROPERTIES outside = EFX_REVERB_PRESET_PLAIN;
+
+    for (int zoneCount : zoneCounts)
+    {
+        int side = static_cast<int>(std::sqrt(static_cast<double>(zoneCount)));
+        OpenAL::ReverbZoneSet zones;
+        for (int i = 0; i < zoneCount; ++i)
+        {
+            OpenAL::Vec3 center((i % side) * 20.f, 0.f, (i / side) * 20.f);
+            float size = 6.f + (i * 37) % 7;
+            if (i % 4 == 0)
+            {
+                zones.Add(OpenAL::ReverbZone::Sphere(center, size, room, 2.f));
+            }
+            else
+            {
+                zones.Add(OpenAL::ReverbZone::Box(center, OpenAL::Vec3(size, 4.f, size), room, 2.f, i % 3));
+            }
+        }
+
+        // Walk the listener across the whole layout so lookups land inside, between and across zones
+        float extent = side * 20.f;
+        // Summing the results, and reporting the mean, keeps the lookups from being optimized away
+        double decayTime = 0.0;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < lookups; ++i)
+        {
+            OpenAL::Vec3 point(std::fmod(i * 0.73f, extent), 1.f, std::fmod(i * 0.11f, extent));
+            decayTime += zones.Evaluate(point, outside).flDecayTime;
+        }
+        double seconds = SecondsSince(start);
+
+        json.Add("zone_lookup", { { "zones", zoneCount }, { "calls", lookups }, { "ns_per_call", seconds * 1.0e9 / lookups }, { "mean_decay_time", decayTime / lookups } });
+    }
+}
+
+// alGetError calls per frame of ten Play() calls and an update, with error checking on and off.
+// default_checked is 1 when the library starts with checking on, as Debug builds do.
+void BenchErrorChecks(JsonWriter& json)
+{
+    const int frames = 100;
+    const int playsPerFrame = 10;
+    const OpenAL::ErrorPolicy policies[] = { OpenAL::ErrorPolicyChecked, OpenAL::ErrorPolicyUnchecked };
+
+    OpenAL::ErrorPolicy previous = OpenAL::GetErrorPolicy();
+    for (OpenAL::ErrorPolicy policy : policies)
+    {
+        OpenAL::SetErrorPolicy(policy);
+        Engine engine;
+        if (!engine.IsValid())
+        {
+            break;
+        }
+
+        std::vector<OpenAL::Sound*> sounds;
+        for (int i = 0; i < playsPerFrame; ++i)
+        {
+            ALuint buffer = engine.pContext->CreateBuffer(MakeWav(1, 16, 2205));
+            engine.pContext->RegisterBuffer(buffer);
+            sounds.push_back(new OpenAL::Sound(buffer, engine.pContext));
+        }
+
+        std::vector<char> block(735 * engine.pDevice->GetFrameSize());
+        unsigned int checks = OpenAL::t_numErrorChecks;
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            for (OpenAL::Sound* pSound : sounds)
+            {
+                pSound->Play();
+            }
+            engine.pContext->Update();
+            engine.pDevice->Render(&block[0], 735);
+        }
+        checks = OpenAL::t_numErrorChecks - checks;
+
+        json.Add(policy == OpenAL::ErrorPolicyChecked ? "error_checks_checked" : "error_checks_unchecked",
+            { { "default_checked", previous == OpenAL::ErrorPolicyChecked }, { "plays_per_frame", playsPerFrame },
+              { "al_get_error_per_frame", static_cast<double>(checks) / frames } });
+
+        for (OpenAL::Sound* pSound : sounds)
+        {
+            delete pSound;
+        }
+    }
+    OpenAL::SetErrorPolicy(previous);
+}
+
+double Percentile(std::vector<double> samples, double percentile)
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+    size_t rank = std::min(static_cast<size_t>(percentile * samples.size()), samples.size() - 1);
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+
+struct StressOptions
+{
+    int             rate;
+    int             seconds;
+    int             sounds;
+    unsigned int    maxSources;
+};
+
+// Fires overlapping one-shots round robin across many sounds at a fixed rate, a frame at a
+// time, and reports how the source pool and the mixer hold up
+void RunStress(JsonWriter& json, const StressOptions& options)
+{
+    const int frequency     = 44100;
+    const int framesPerTick = frequency / 60;
+
+    Engine engine;
+    if (!engine.IsValid())
+    {
+        return;
+    }
+    engine.pContext->SetMaxSources(options.maxSources);
+
+    // One-shots between 50 and 300 ms long
+    std::vector<OpenAL::Sound*> sounds;
+    for (int i = 0; i < options.sounds; ++i)
+    {
+        int frames = frequency * (50 + (i * 37) % 250) / 1000;
+        ALuint buffer = engine.pContext->CreateBuffer(MakeWav(1, 16, frames, frequency));
+        engine.pContext->RegisterBuffer(buffer);
+        sounds.push_back(new OpenAL::Sound(buffer, engine.pContext));
+    }
+
+    std::vector<char>   block(framesPerTick * engine.pDevice->GetFrameSize());
+    std::vector<double> playTimes;
+    std::vector<double> mixTimes;
+    std::vector<double> updateTimes;
+    int ticks = options.seconds * 60;
+    playTimes.reserve(static_cast<size_t>(options.rate) * options.seconds);
+
+    double owed = 0.0;
+    size_t next = 0;
+    Clock::time_point runStart = Clock::now();
+    for (int tick = 0; tick < ticks; ++tick)
+    {
+        Clock::time_point start = Clock::now();
+        engine.pContext->Update();
+        updateTimes.push_back(SecondsSince(start));
+
+        owed += static_cast<double>(options.rate) / 60.0;
+        for (; owed >= 1.0; owed -= 1.0)
+        {
+            OpenAL::Sound* pSound = sounds[next++ % sounds.size()];
+            start = Clock::now();
+            pSound->Play();
+            playTimes.push_back(SecondsSince(start));
+        }
+
+        start = Clock::now();
+        engine.pDevice->Render(&block[0], framesPerTick);
+        mixTimes.push_back(SecondsSince(start));
+    }
+    double runSeconds = SecondsSince(runStart);
+    OpenAL::AudioStats stats = engine.pContext->GetStats();
+
+    double mixTotal = 0.0;
+    for (double mixTime : mixTimes)
+    {
+        mixTotal += mixTime;
+    }
+
+    json.Add("stress", {
+        { "plays",              static_cast<double>(playTimes.size()) },
+        { "rendered_seconds",   options.seconds },
+        { "max_sources",        options.maxSources },
+        { "sources_created",    engine.pContext->GetNumSources() },
+        { "peak_pool_size",     static_cast<double>(engine.pContext->GetPeakPoolSize()) },
+        { "stolen_voices",      engine.pContext->GetNumStolenVoices() },
+        { "play_ns_p50",        Percentile(playTimes, 0.50) * 1.0e9 },
+        { "play_ns_p99",        Percentile(playTimes, 0.99) * 1.0e9 },
+        { "play_ns_max",        Percentile(playTimes, 1.00) * 1.0e9 },
+        { "update_us_p50",      Percentile(updateTimes, 0.50) * 1.0e6 },
+        { "update_us_p99",      Percentile(updateTimes, 0.99) * 1.0e6 },
+        { "mix_us_per_tick",    mixTotal * 1.0e6 / ticks },
+        { "mix_us_p99",         Percentile(mixTimes, 0.99) * 1.0e6 },
+        { "al_calls_per_tick",  stats.alCallsPerFrame },
+        { "buffer_hits",        stats.bufferHits },
+        { "resident_bytes",     static_cast<double>(stats.residentBytes) },
+        { "realtime_factor",    options.seconds / runSeconds }
+    });
+
+    for (OpenAL::Sound* pSound : sounds)
+    {
+        delete pSound;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    bool            stress = false;
+    StressOptions   options = { 4000, 10, 64, 256 };
+    const char*     pOutput = NULL;
+    const char*     pTrace = NULL;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--stress")
+        {
+            stress = true;
+        }
+        else if (arg == "--rate" && hasValue)
+        {
+            options.rate = atoi(argv[++i]);
+        }
+        else if (arg == "--seconds" && hasValue)
+        {
+            options.seconds = atoi(argv[++i]);
+        }
+        else if (arg == "--sounds" && hasValue)
+        {
+            options.sounds = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--max-sources" && hasValue)
+        {
+            options.maxSources = static_cast<unsigned int>(atoi(argv[++i]));
+        }
+        else if (arg == "--trace" && hasValue)
+        {
+            pTrace = argv[++i];
+        }
+        else
+        {
+            pOutput = argv[i];
+        }
+    }
+
+    JsonWriter json;
+    if (stress)
+    {
+        RunStress(json, options);
+    }
+    else
+    {
+        BenchPlay(json);
+        BenchGetSource(json);
+        BenchCreateBuffer(json);
+        BenchUpdate(json);
+        BenchZoneLookup(json);
+        BenchErrorChecks(json);
+    }
+    std::string result = json.Finish();
+
+    if (pTrace)
+    {
+        std::ofstream file(pTrace);
+        OpenAL::DumpTrace(file);
+    }
+
+    if (pOutput)
+    {
+        std::ofstream file(pOutput);
+        file << result;
+    }
+    else
+    {
+        std::cout << result;
+    }
+    return 0;
+}
@@ -1,12 +1,29 @@
-#include "OpenAL.h"
+#include "OpenALCore.h"
+
+// The default error policy; only this file reads it, so it can differ from the NDEBUG of the
+// code that includes the block
+#ifndef OPENAL_CHECK_ERRORS
+#ifdef NDEBUG
+#define OPENAL_CHECK_ERRORS 0
+#else
+#define OPENAL_CHECK_ERRORS 1
+#endif
+#endif
 
 // Specify storage for the OpenAL global variables
 namespace OpenAL
 {
-    ALCdevice*          g_pAlDevice;
-    ALCcontext*         g_pAlContext;
-    std::deque<ALuint>  g_sources;
-    std::deque<ALuint>  g_buffers;
-    unsigned int        g_numBuffers;
-    unsigned int        g_numSources;
+    AudioDevice*        g_pDefaultDevice;
+    AudioContext*       g_pDefaultContext;
+    OPENAL_THREAD_LOCAL AudioContext* t_pCurrentContext;
+    std::atomic<ALCcontext*>          g_pCurrentAlContext(NULL);
+    OPENAL_THREAD_LOCAL unsigned int  t_numAlCalls;
+    ErrorPolicy         g_errorPolicy = OPENAL_CHECK_ERRORS ? ErrorPolicyChecked : ErrorPolicyUnchecked;
+    ErrorCallback       g_errorCallback;
+    OPENAL_THREAD_LOCAL ALenum        t_lastAlError;
+    OPENAL_THREAD_LOCAL ALenum        t_unreportedAlError;
+    OPENAL_THREAD_LOCAL unsigned int  t_numErrorChecks;
+#ifdef OPENAL_TRACE_CALLS
+    OPENAL_THREAD_LOCAL TraceRing*    t_pTraceRing;
+#endif
 } // namespace OpenAL
@@ -0,0 +1,823 @@
+// Behavior tests for the engine, run on an ALC_SOFT_loopback device so no audio hardware is
+// needed. Each test renders and updates a frame at a time, as an application would, and
+// checks what the engine reports. Exits non-zero if any check fails.
+//
+//   ctest --test-dir build    or    build/OpenALTests
+
+#include "OpenALCore.h"
+
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+int g_failures = 0;
+
+#define CHECK(condition) \
+    do { if (!(condition)) { ++g_failures; std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; } } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+    do { if (std::fabs((a) - (b)) > (tolerance)) { ++g_failures; std::cerr << __FILE__ << ":" << __LINE__ << ": " #a " is " << (a) << ", expected " << (b) << std::endl; } } while (0)
+
+const int g_frequency     = 44100;
+const int g_framesPerTick = 441;    // 10 ms
+
+// A mono 16 bit .wav of silence, looping [loopStart, loopEnd) when loopEnd is not 0
+OpenAL::WavSourceRef MakeWav(int frames, uint32_t loopStart = 0, uint32_t loopEnd = 0)
+{
+    std::vector<char> wav = OpenAL::WriteWav(1, 16, frames, g_frequency, loopStart, loopEnd);
+    return std::make_shared<OpenAL::MemoryWavSource>(&wav[0], wav.size());
+}
+
+// A loopback device with one context, stepped a tick at a time
+struct Engine
+{
+    OpenAL::AudioDevice*    pDevice;
+    OpenAL::AudioContext*   pContext;
+    std::vector<char>       block;
+
+    Engine()
+    {
+        OpenAL::LoopbackFormat format = { g_frequency, ALC_STEREO_SOFT, ALC_SHORT_SOFT };
+        pDevice  = new OpenAL::AudioDevice(format);
+        pContext = pDevice->CreateContext();
+        block.resize(g_framesPerTick * std::max(1, pDevice->GetFrameSize()));
+    }
+
+    ~Engine()
+    {
+        delete pDevice;
+    }
+
+    bool IsValid() const { return pContext != NULL; }
+
+    void Run(double seconds)
+    {
+        for (int tick = 0; tick < static_cast<int>(seconds * g_frequency / g_framesPerTick + 0.5); ++tick)
+        {
+            pDevice->Render(&block[0], g_framesPerTick);
+            pContext->Update();
+        }
+    }
+};
+
+// The loopback device clock advances by exactly the frames rendered, whatever the block size
+void TestLoopbackClock()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+
+    CHECK(engine.pContext->GetDeviceTime() == 0.0);
+    engine.pDevice->Render(&engine.block[0], g_framesPerTick);
+    CHECK(engine.pDevice->GetRenderedFrames() == g_framesPerTick);
+    CHECK(engine.pContext->GetDeviceTime() == static_cast<double>(g_framesPerTick) / g_frequency);
+
+    std::vector<char> odd(1000 * engine.pDevice->GetFrameSize());
+    engine.pDevice->Render(&odd[0], 1000);
+    CHECK(engine.pDevice->GetRenderedFrames() == g_framesPerTick + 1000);
+    CHECK(engine.pContext->GetDeviceTime() == static_cast<double>(g_framesPerTick + 1000) / g_frequency);
+}
+
+// A PlayAt on the loopback timeline stays silent until its time and is then heard from the
+// frame it would have reached had it started exactly then
+void TestLoopbackPlayAt()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+
+    ALuint buffer = engine.pContext->CreateBuffer(MakeWav(g_frequency));
+    engine.pContext->RegisterBuffer(buffer);
+    OpenAL::Sound sound(buffer, engine.pContext);
+
+    engine.Run(0.1);
+    double startTime = engine.pContext->GetDeviceTime() + 0.1;
+    sound.PlayAt(startTime);
+    engine.Run(0.05);
+    CHECK(!sound.GetPlaybackPosition().playing);
+
+    engine.Run(0.1);
+    OpenAL::PlaybackPosition position = sound.GetPlaybackPosition();
+    CHECK(position.playing);
+    CHECK_NEAR(static_cast<double>(position.samples), (engine.pContext->GetDeviceTime() - startTime) * g_frequency, 2.0);
+}
+
+// A PlayAt that comes due between two updates starts in the later one, seeked past what
+// would already have been heard, at the sound's pitch
+void TestPlayAtBetweenUpdates()
+{
+    const float pitches[] = { 1.f, 2.f };
+    for (float pitch : pitches)
+    {
+        Engine engine;
+        CHECK(engine.IsValid());
+        if (!engine.IsValid())
+        {
+            return;
+        }
+
+        ALuint buffer = engine.pContext->CreateBuffer(MakeWav(g_frequency));
+        engine.pContext->RegisterBuffer(buffer);
+        OpenAL::Sound sound(buffer, engine.pContext);
+        sound.m_pitch = pitch;
+
+        engine.Run(0.1);
+        double latency   = engine.pContext->GetOutputLatency();
+        double startTime = engine.pContext->GetDeviceTime() + latency + 0.005;
+        sound.PlayAt(startTime);
+        CHECK(!sound.GetPlaybackPosition().playing);
+
+        engine.Run(0.05 + latency);
+        OpenAL::PlaybackPosition position = sound.GetPlaybackPosition();
+        CHECK(position.playing);
+        CHECK_NEAR(static_cast<double>(position.samples), (engine.pContext->GetDeviceTime() - startTime) * g_frequency * pitch, 2.0 * pitch);
+    }
+}
+
+// The first loop of a smpl chunk becomes the buffer's loop points, end exclusive
+void TestSmplLoopPoints()
+{
+    std::vector<char> wav = OpenAL::WriteWav(1, 16, 1000, g_frequency, 200, 800);
+    OpenAL::DataSpan span = { &wav[0], wav.size() };
+    OpenAL::WavData data = OpenAL::ParseWav(span);
+    CHECK(data.loopStart == 200);
+    CHECK(data.loopEnd == 800);
+    CHECK(data.size == 2000);
+
+    std::vector<char> plain = OpenAL::WriteWav(1, 16, 1000);
+    OpenAL::DataSpan plainSpan = { &plain[0], plain.size() };
+    data = OpenAL::ParseWav(plainSpan);
+    CHECK(data.loopStart == 0 && data.loopEnd == 0);
+
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (engine.IsValid())
+    {
+        // AL_SOFT_loop_points has been in OpenAL Soft since 1.14
+        ALuint buffer = engine.pContext->CreateBuffer(MakeWav(1000, 200, 800));
+        ALint start = 0;
+        ALint end   = 0;
+        CHECK(engine.pContext->GetLoopPoints(buffer, start, end));
+        CHECK(start == 200 && end == 800);
+        engine.pContext->DestroyBuffer(buffer);
+    }
+}
+
+// Past the source cap, with every source held by a sound, the longest playing voice gives
+// up its source
+void TestVoiceStealing()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+    engine.pContext->SetMaxSources(2);
+
+    ALuint buffer = engine.pContext->CreateBuffer(MakeWav(g_frequency));
+    engine.pContext->RegisterBuffer(buffer);
+    OpenAL::Sound first(buffer, engine.pContext);
+    OpenAL::Sound second(buffer, engine.pContext);
+    OpenAL::Sound third(buffer, engine.pContext);
+
+    first.Play();
+    engine.Run(0.02);
+    second.Play();
+    engine.Run(0.02);
+    third.Play();
+    engine.Run(0.02);
+
+    CHECK(engine.pContext->GetNumSources() == 2);
+    CHECK(engine.pContext->GetNumStolenVoices() == 1);
+    CHECK(!first.GetPlaybackPosition().playing);
+    CHECK(second.GetPlaybackPosition().playing);
+    CHECK(third.GetPlaybackPosition().playing);
+}
+
+// Bus gains multiply down the tree and a mute silences the whole subtree
+void TestBuses()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+    OpenAL::AudioContext* pContext = engine.pContext;
+
+    unsigned int sfx     = pContext->CreateBus("SFX");
+    unsigned int weapons = pContext->CreateBus("Weapons", sfx);
+    unsigned int music   = pContext->CreateBus("Music");
+    CHECK(pContext->FindBus("Weapons") == weapons);
+    CHECK(pContext->CreateBus("Orphan", 1000) == OpenAL::InvalidBus);
+
+    pContext->SetBusVolume(OpenAL::MasterBus, 0.5f);
+    pContext->SetBusVolume(sfx, 0.5f);
+    pContext->SetBusVolume(weapons, 0.8f);
+    CHECK_NEAR(pContext->GetBusGain(weapons), 0.2f, 1.0e-6f);
+    CHECK_NEAR(pContext->GetBusGain(music), 0.5f, 1.0e-6f);
+    pContext->SetBusMuted(sfx, true);
+    CHECK(pContext->GetBusGain(weapons) == 0.f);
+    CHECK_NEAR(pContext->GetBusGain(music), 0.5f, 1.0e-6f);
+    pContext->SetBusMuted(sfx, false);
+    pContext->SetBusVolume(OpenAL::MasterBus, 1.f);
+    CHECK_NEAR(pContext->GetBusGain(weapons), 0.4f, 1.0e-6f);
+}
+
+// Ducking moves the target bus down while the trigger bus plays and back once it stops
+void TestDucking()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+    OpenAL::AudioContext* pContext = engine.pContext;
+
+    unsigned int music = pContext->CreateBus("Music");
+    unsigned int vo    = pContext->CreateBus("VO");
+    pContext->AddDucking(vo, music, 6.f, 0.05, 0.1);
+
+    ALuint buffer = pContext->CreateBuffer(MakeWav(g_frequency));
+    pContext->RegisterBuffer(buffer);
+    OpenAL::Sound line(buffer, pContext);
+    line.m_bus     = vo;
+    line.m_looping = true;
+
+    engine.Run(0.05);
+    CHECK_NEAR(pContext->GetBusGain(music), 1.f, 1.0e-6f);
+    line.Play();
+    engine.Run(0.2);
+    CHECK_NEAR(pContext->GetBusGain(music), std::pow(10.f, -6.f / 20.f), 1.0e-3f);
+    CHECK_NEAR(pContext->GetBusGain(vo), 1.f, 1.0e-6f);
+    line.Stop();
+    engine.Run(0.3);
+    CHECK_NEAR(pContext->GetBusGain(music), 1.f, 1.0e-3f);
+}
+
+// Fades land exactly on their target; a fade-out stops the sound and restores its gain
+void TestFades()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+
+    ALuint buffer = engine.pContext->CreateBuffer(MakeWav(g_frequency));
+    engine.pContext->RegisterBuffer(buffer);
+    OpenAL::Sound sound(buffer, engine.pContext);
+    sound.m_looping = true;
+
+    sound.Play();
+    sound.FadeTo(0.25f, 0.1, OpenAL::FadeSmooth);
+    engine.Run(0.05);
+    CHECK(sound.m_gain < 1.f && sound.m_gain > 0.25f);
+    engine.Run(0.1);
+    CHECK(sound.m_gain == 0.25f);
+
+    sound.RampPitch(2.f, 0.05);
+    engine.Run(0.1);
+    CHECK(sound.m_pitch == 2.f);
+
+    sound.FadeOut(0.1, OpenAL::FadeEqualPower);
+    engine.Run(0.05);
+    CHECK(sound.GetPlaybackPosition().playing);
+    engine.Run(0.1);
+    CHECK(!sound.GetPlaybackPosition().playing);
+    CHECK(sound.m_gain == 0.25f);
+}
+
+// Zones of one priority share their tier whatever order they were added in, a higher
+// priority covers what it is inside of, and zones overlapping by their fade leave no gap
+void TestReverbZoneTiers()
+{
+    EFXEAXREVERBPROPERTIES outside = EFX_REVERB_PRESET_GENERIC;
+    EFXEAXREVERBPROPERTIES hall    = EFX_REVERB_PRESET_GENERIC;
+    EFXEAXREVERBPROPERTIES cave    = EFX_REVERB_PRESET_GENERIC;
+    EFXEAXREVERBPROPERTIES booth   = EFX_REVERB_PRESET_GENERIC;
+    outside.flDecayTime = 10.f;
+    hall.flDecayTime    = 1.f;
+    cave.flDecayTime    = 3.f;
+    booth.flDecayTime   = 0.5f;
+
+    OpenAL::ReverbZoneSet forward;
+    OpenAL::ReverbZoneSet backward;
+    OpenAL::ReverbZone hallZone = OpenAL::ReverbZone::Box(OpenAL::Vec3(0.f, 0.f, 0.f), OpenAL::Vec3(10.f, 10.f, 10.f), hall, 1.f);
+    OpenAL::ReverbZone caveZone = OpenAL::ReverbZone::Box(OpenAL::Vec3(9.f, 0.f, 0.f), OpenAL::Vec3(10.f, 10.f, 10.f), cave, 1.f);
+    forward.Add(hallZone);
+    forward.Add(caveZone);
+    backward.Add(caveZone);
+    backward.Add(hallZone);
+
+    // Deep inside both: an even split, in either order
+    OpenAL::Vec3 both(4.5f, 0.f, 0.f);
+    CHECK_NEAR(forward.Evaluate(both, outside).flDecayTime, 2.f, 1.0e-5f);
+    CHECK_NEAR(backward.Evaluate(both, outside).flDecayTime, 2.f, 1.0e-5f);
+
+    // Across a seam where two zones overlap by their fade, the outside never comes in
+    OpenAL::ReverbZoneSet seam;
+    seam.Add(hallZone);
+    seam.Add(OpenAL::ReverbZone::Box(OpenAL::Vec3(19.f, 0.f, 0.f), OpenAL::Vec3(10.f, 10.f, 10.f), cave, 1.f));
+    for (float x = 9.f; x <= 10.f; x += 0.25f)
+    {
+        CHECK_NEAR(seam.Evaluate(OpenAL::Vec3(x, 0.f, 0.f), outside).flDecayTime, 1.f + 2.f * (x - 9.f), 1.0e-4f);
+    }
+
+    // Halfway through the fade of a lone zone, half of the outside is heard
+    CHECK_NEAR(forward.Evaluate(OpenAL::Vec3(-9.5f, 0.f, 0.f), outside).flDecayTime, 5.5f, 1.0e-5f);
+
+    // A higher priority zone nested in both takes the point over
+    forward.Add(OpenAL::ReverbZone::Sphere(both, 2.f, booth, 1.f, 1));
+    CHECK_NEAR(forward.Evaluate(both, outside).flDecayTime, 0.5f, 1.0e-5f);
+    CHECK_NEAR(forward.Evaluate(both + OpenAL::Vec3(1.5f, 0.f, 0.f), outside).flDecayTime, 0.5f * 0.5f + 2.f * 0.5f, 1.0e-5f);
+}
+
+// A device that fails to open in the background drops the plays queued for it and says so;
+// plays after that do nothing
+void TestFailedAsyncOpen()
+{
+    std::vector<std::string> errors;
+    OpenAL::SetErrorCallback([&errors](const std::string& message, ALenum) { errors.push_back(message); });
+
+    OpenAL::AudioDevice device("No such output device", true);
+    OpenAL::AudioContext* pContext = device.CreateContext();
+    CHECK(pContext != NULL);
+    if (pContext)
+    {
+        ALuint buffer = pContext->CreateBuffer(MakeWav(g_frequency));
+        pContext->RegisterBuffer(buffer);
+        OpenAL::Sound sound(buffer, pContext);
+        sound.Play();
+        CHECK(device.IsOpening());
+
+        auto start = std::chrono::steady_clock::now();
+        while (device.IsOpening() && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+        {
+            pContext->Update();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(!device.IsOpening());
+        CHECK(!device.IsOpen());
+        CHECK(!pContext->IsValid());
+        CHECK(errors.size() == 1 && errors[0].find("dropped 1 queued plays") != std::string::npos);
+
+        sound.Play();
+        pContext->Update();
+        CHECK(!sound.GetPlaybackPosition().playing);
+    }
+    OpenAL::SetErrorCallback(OpenAL::ErrorCallback());
+}
+
+// Each play counts one buffer hit or miss, a miss when it had to load the buffer; looking a
+// buffer up does not count
+void TestBufferHitsAndMisses()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+
+    OpenAL::Sound deferred(MakeWav(g_frequency), engine.pContext);
+    deferred.Play();
+    engine.Run(0.02);
+    OpenAL::AudioStats stats = engine.pContext->GetStats();
+    CHECK(stats.bufferMisses == 1);
+    CHECK(stats.bufferHits == 0);
+
+    deferred.Play();
+    engine.pContext->ResolveBuffer(deferred.GetBuffer());
+    engine.Run(0.02);
+    stats = engine.pContext->GetStats();
+    CHECK(stats.bufferMisses == 1);
+    CHECK(stats.bufferHits == 1);
+}
+
+// Plays too quiet at the listener get no source: one-shots are dropped and loops wait as
+// virtual voices, one per sound unless the plays overlap. A restart that is culled stops the
+// voice the sound was playing.
+void TestCulling()
+{
+    CHECK_NEAR(OpenAL::GetDistanceGain(AL_INVERSE_DISTANCE_CLAMPED, 10.f, 1.f, FLT_MAX, 1.f), 0.1f, 1.0e-6f);
+    CHECK_NEAR(OpenAL::GetDistanceGain(AL_LINEAR_DISTANCE_CLAMPED, 5.f, 1.f, 9.f, 1.f), 0.5f, 1.0e-6f);
+    CHECK(OpenAL::GetDistanceGain(AL_NONE, 1000.f, 1.f, FLT_MAX, 1.f) == 1.f);
+
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+    OpenAL::AudioContext* pContext = engine.pContext;
+
+    ALuint buffer = pContext->CreateBuffer(MakeWav(g_frequency));
+    pContext->RegisterBuffer(buffer);
+    OpenAL::Sound loop(buffer, pContext);
+    OpenAL::Sound shot(buffer, pContext);
+    loop.m_looping  = true;
+    loop.m_position = OpenAL::Vec3(100000.f, 0.f, 0.f);
+    shot.m_position = loop.m_position;
+    CHECK(!pContext->IsAudible(loop));
+    loop.m_position = OpenAL::Vec3(1.f, 0.f, 0.f);
+    CHECK(pContext->IsAudible(loop));
+
+    // Heard, then restarted out of range
+    loop.Play();
+    engine.Run(0.02);
+    CHECK(loop.GetPlaybackPosition().playing);
+    loop.m_position = shot.m_position;
+    loop.Play(false);
+    engine.Run(0.02);
+    CHECK(!loop.GetPlaybackPosition().playing);
+    CHECK(pContext->GetStats().virtualVoices == 1);
+
+    loop.Play(false);
+    loop.Play(false);
+    CHECK(pContext->GetStats().virtualVoices == 1);
+    loop.Play();
+    CHECK(pContext->GetStats().virtualVoices == 2);
+
+    shot.Play();
+    OpenAL::AudioStats stats = pContext->GetStats();
+    CHECK(stats.virtualVoices == 2);
+    CHECK(stats.culledPlays == 5);
+}
+
+// A culled loop that comes within range starts where it would have been had it been heard
+// all along, at its pitch
+void TestVirtualLoopResume()
+{
+    const float pitches[] = { 1.f, 2.f };
+    for (float pitch : pitches)
+    {
+        Engine engine;
+        CHECK(engine.IsValid());
+        if (!engine.IsValid())
+        {
+            return;
+        }
+
+        ALuint buffer = engine.pContext->CreateBuffer(MakeWav(g_frequency));
+        engine.pContext->RegisterBuffer(buffer);
+        OpenAL::Sound sound(buffer, engine.pContext);
+        sound.m_looping  = true;
+        sound.m_pitch    = pitch;
+        sound.m_position = OpenAL::Vec3(100000.f, 0.f, 0.f);
+
+        engine.Run(0.1);
+        double playTime = engine.pContext->GetDeviceTime();
+        sound.Play();
+        engine.Run(0.2);
+        CHECK(!sound.GetPlaybackPosition().playing);
+
+        sound.m_position = OpenAL::Vec3(1.f, 0.f, 0.f);
+        engine.Run(0.1);
+        OpenAL::PlaybackPosition position = sound.GetPlaybackPosition();
+        CHECK(position.playing);
+        // Had it been heard, the first frame would have come out an output latency after Play
+        double heard    = engine.pContext->GetDeviceTime() - playTime - engine.pContext->GetOutputLatency();
+        double expected = std::fmod(heard * g_frequency * pitch, static_cast<double>(g_frequency));
+        CHECK_NEAR(static_cast<double>(position.samples), expected, 2.0 * pitch);
+    }
+}
+
+// An emitter is found from inside its radius only, follows its moves and radius changes, and
+// is still found once it covers too many cells for the grid, or after the grid is rebuilt
+void TestEmitterGrid()
+{
+    OpenAL::EmitterGrid grid(8.f);
+    unsigned int torch = grid.Add(OpenAL::Vec3(0.f, 0.f, 0.f), 10.f);
+    std::vector<unsigned int> found;
+    grid.Query(OpenAL::Vec3(5.f, 0.f, 0.f), found);
+    CHECK(found.size() == 1 && found[0] == torch);
+
+    grid.Move(torch, OpenAL::Vec3(100.f, 0.f, 0.f));
+    found.clear();
+    grid.Query(OpenAL::Vec3(5.f, 0.f, 0.f), found);
+    CHECK(found.empty());
+    grid.Query(OpenAL::Vec3(95.f, 0.f, 0.f), found);
+    CHECK(found.size() == 1 && found[0] == torch);
+
+    grid.SetRadius(torch, 1.f);
+    found.clear();
+    grid.Query(OpenAL::Vec3(95.f, 0.f, 0.f), found);
+    CHECK(found.empty());
+
+    unsigned int river = grid.Add(OpenAL::Vec3(0.f, 0.f, 0.f), 100000.f);
+    grid.Query(OpenAL::Vec3(-5000.f, 0.f, 300.f), found);
+    CHECK(found.size() == 1 && found[0] == river);
+
+    grid.SetCellSize(64.f);
+    found.clear();
+    grid.Query(OpenAL::Vec3(100.5f, 0.f, 0.f), found);
+    CHECK(found.size() == 2);
+
+    grid.Remove(river);
+    grid.Remove(torch);
+    found.clear();
+    grid.Query(OpenAL::Vec3(100.f, 0.f, 0.f), found);
+    CHECK(found.empty() && grid.IsEmpty());
+}
+
+// An emitter plays while the listener is within its radius and gives up its source when the
+// listener leaves
+void TestEmitterRange()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+    OpenAL::AudioContext* pContext = engine.pContext;
+
+    ALuint buffer = pContext->CreateBuffer(MakeWav(g_frequency));
+    pContext->RegisterBuffer(buffer);
+    OpenAL::Sound torch(buffer, pContext);
+    torch.m_looping  = true;
+    torch.m_position = OpenAL::Vec3(50.f, 0.f, 0.f);
+    pContext->AddEmitter(&torch, 10.f);
+
+    engine.Run(0.02);
+    CHECK(!torch.GetPlaybackPosition().playing);
+    CHECK(pContext->GetStats().emittersInRange == 0);
+
+    pContext->SetListenerPosition(OpenAL::Vec3(45.f, 0.f, 0.f));
+    engine.Run(0.02);
+    CHECK(torch.GetPlaybackPosition().playing);
+    CHECK(pContext->GetStats().emittersInRange == 1);
+
+    pContext->SetListenerPosition(OpenAL::Vec3(0.f, 0.f, 0.f));
+    engine.Run(0.02);
+    CHECK(!torch.GetPlaybackPosition().playing);
+    CHECK(pContext->GetStats().emittersInRange == 0);
+    CHECK(pContext->GetStats().numEmitters == 1);
+}
+
+// Over the memory budget, the least recently used buffer that is not playing is evicted, and
+// reloaded when it is next played
+void TestMemoryBudget()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+    OpenAL::AudioContext* pContext = engine.pContext;
+
+    OpenAL::Sound first(MakeWav(g_frequency / 10), pContext);
+    OpenAL::Sound second(MakeWav(g_frequency / 10), pContext);
+    OpenAL::Sound third(MakeWav(g_frequency / 10), pContext);
+    OpenAL::Sound* sounds[] = { &first, &second, &third, &first };
+    for (OpenAL::Sound* pSound : sounds)
+    {
+        pSound->Play();
+        engine.Run(0.2);
+    }
+    OpenAL::AudioStats stats = pContext->GetStats();
+    size_t bytes = stats.residentBytes / 3;
+    CHECK(bytes > 0);
+    CHECK(stats.numBuffers == 3);
+    CHECK(stats.bufferMisses == 3);
+
+    // second is now the least recently used
+    pContext->SetMemoryBudget(2 * bytes);
+    stats = pContext->GetStats();
+    CHECK(stats.bufferEvictions == 1);
+    CHECK(stats.residentBytes == 2 * bytes);
+
+    third.Play();
+    engine.Run(0.2);
+    CHECK(pContext->GetStats().bufferMisses == 3);
+
+    // Reloading second pushes out first, which has gone longest unplayed
+    second.Play();
+    engine.Run(0.02);
+    stats = pContext->GetStats();
+    CHECK(second.GetPlaybackPosition().playing);
+    CHECK(stats.bufferMisses == 4);
+    CHECK(stats.bufferEvictions == 2);
+    CHECK(stats.residentBytes == 2 * bytes);
+    third.Play();
+    CHECK(pContext->GetStats().bufferMisses == 4);
+    first.Play();
+    CHECK(pContext->GetStats().bufferMisses == 5);
+}
+
+// A sound made from a source loads nothing until it is first played; buffers prewarmed with
+// pin are loaded up front and survive the memory budget until unpinned
+void TestDeferredAndPinned()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+    OpenAL::AudioContext* pContext = engine.pContext;
+
+    OpenAL::Sound lazy(MakeWav(g_frequency / 10), pContext);
+    OpenAL::Sound pinned(MakeWav(g_frequency / 10), pContext);
+    OpenAL::AudioStats stats = pContext->GetStats();
+    CHECK(stats.numBuffers == 0);
+    CHECK(stats.residentBytes == 0);
+
+    lazy.Play();
+    engine.Run(0.2);
+    stats = pContext->GetStats();
+    CHECK(stats.numBuffers == 1);
+    CHECK(stats.bufferMisses == 1);
+    size_t bytes = stats.residentBytes;
+    CHECK(bytes > 0);
+
+    pContext->Prewarm(std::vector<ALuint>(1, pinned.GetBuffer()), true);
+    CHECK(pContext->GetStats().numBuffers == 2);
+
+    // pinned is the most recently used, but only lazy can go
+    pContext->SetMemoryBudget(1);
+    stats = pContext->GetStats();
+    CHECK(stats.numBuffers == 1);
+    CHECK(stats.residentBytes == bytes);
+    pinned.Play();
+    CHECK(pContext->GetStats().bufferMisses == 1);
+    engine.Run(0.2);
+
+    pContext->Unpin(std::vector<ALuint>(1, pinned.GetBuffer()));
+    stats = pContext->GetStats();
+    CHECK(stats.numBuffers == 0);
+    CHECK(stats.residentBytes == 0);
+}
+
+// With SetAutoVelocity and no smoothing, the listener and playing sounds move at how far they
+// went since the last update over the device time between the two
+void TestAutoVelocity()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+    OpenAL::AudioContext* pContext = engine.pContext;
+
+    ALuint buffer = pContext->CreateBuffer(MakeWav(g_frequency));
+    pContext->RegisterBuffer(buffer);
+    OpenAL::Sound car(buffer, pContext);
+    car.m_looping = true;
+    car.Play();
+    pContext->SetAutoVelocity(true, 0.0);
+
+    const double tick = static_cast<double>(g_framesPerTick) / g_frequency;
+    const OpenAL::Vec3 listenerStep(0.1f, 0.f, 0.f);
+    const OpenAL::Vec3 carStep(0.f, -0.02f, 0.05f);
+    OpenAL::Vec3 listener;
+    for (int i = 0; i < 10; ++i)
+    {
+        listener = listener + listenerStep;
+        car.m_position = car.m_position + carStep;
+        pContext->SetListenerPosition(listener);
+        engine.Run(tick);
+    }
+
+    ALfloat velocity[3];
+    alGetListenerfv(AL_VELOCITY, velocity);
+    CHECK_NEAR(velocity[0], listenerStep.x / tick, 1.0e-3);
+    CHECK_NEAR(velocity[1], 0.0, 1.0e-3);
+    alGetSourcefv(car.GetAlSource(), AL_VELOCITY, velocity);
+    CHECK_NEAR(velocity[1], carStep.y / tick, 1.0e-3);
+    CHECK_NEAR(velocity[2], carStep.z / tick, 1.0e-3);
+
+    // Standing still settles at rest
+    engine.Run(0.1);
+    alGetSourcefv(car.GetAlSource(), AL_VELOCITY, velocity);
+    CHECK(velocity[0] == 0.f && velocity[1] == 0.f && velocity[2] == 0.f);
+}
+
+// A reopened loopback device keeps its clock, and a looping voice moves to it in the next
+// update, heard from the offset it had reached. A second reopen waits for the move.
+void TestLoopbackReopen()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+
+    ALuint buffer = engine.pContext->CreateBuffer(MakeWav(g_frequency));
+    engine.pContext->RegisterBuffer(buffer);
+    OpenAL::Sound sound(buffer, engine.pContext);
+    sound.m_looping = true;
+
+    engine.Run(0.1);
+    double playTime = engine.pContext->GetDeviceTime();
+    sound.Play();
+    engine.Run(0.25);
+
+    ALCdevice* pOldDevice = engine.pDevice->GetAlDevice();
+    int64_t    rendered   = engine.pDevice->GetRenderedFrames();
+    CHECK(engine.pDevice->Reopen());
+    CHECK(engine.pDevice->GetAlDevice() != pOldDevice);
+    CHECK(engine.pDevice->GetRenderedFrames() == rendered);
+    CHECK(engine.pDevice->GetNumReopens() == 1);
+    CHECK(!engine.pDevice->Reopen());
+
+    engine.Run(0.01);
+    OpenAL::PlaybackPosition position = sound.GetPlaybackPosition();
+    CHECK(position.playing);
+    double heard = engine.pContext->GetDeviceTime() - playTime - engine.pContext->GetOutputLatency();
+    CHECK_NEAR(static_cast<double>(position.samples), heard * g_frequency, 2.0);
+
+    // The new source mixes an output latency ahead of what is heard, as the old one did
+    ALint offset = 0;
+    alGetSourcei(sound.GetAlSource(), AL_SAMPLE_OFFSET, &offset);
+    CHECK_NEAR(static_cast<double>(offset), (engine.pContext->GetDeviceTime() - playTime) * g_frequency, 2.0);
+
+    CHECK(engine.pDevice->Reopen());
+    CHECK(engine.pDevice->GetNumReopens() == 2);
+}
+
+// With two contexts, the old device stays open until both have moved off it in their own updates
+void TestReopenTwoContexts()
+{
+    Engine engine;
+    CHECK(engine.IsValid());
+    if (!engine.IsValid())
+    {
+        return;
+    }
+    OpenAL::AudioContext* pSecond = engine.pDevice->CreateContext();
+    CHECK(pSecond != NULL);
+    if (pSecond == NULL)
+    {
+        return;
+    }
+
+    CHECK(engine.pDevice->Reopen());
+    engine.Run(0.01);
+    CHECK(!engine.pDevice->Reopen());
+
+    pSecond->Update();
+    CHECK(pSecond->IsValid());
+    CHECK(engine.pDevice->Reopen());
+
+    // A context destroyed before it moves releases the old device too
+    engine.pDevice->DestroyContext(pSecond);
+    engine.Run(0.01);
+    CHECK(engine.pDevice->Reopen());
+    CHECK(engine.pDevice->GetNumReopens() == 3);
+}
+
+} // namespace
+
+int main()
+{
+    TestLoopbackClock();
+    TestLoopbackPlayAt();
+    TestPlayAtBetweenUpdates();
+    TestSmplLoopPoints();
+    TestVoiceStealing();
+    TestBuses();
+    TestDucking();
+    TestFades();
+    TestReverbZoneTiers();
+    TestFailedAsyncOpen();
+    TestBufferHitsAndMisses();
+    TestCulling();
+    TestVirtualLoopResume();
+    TestEmitterGrid();
+    TestEmitterRange();
+    TestMemoryBudget();
+    TestDeferredAndPinned();
+    TestAutoVelocity();
+    TestLoopbackReopen();
+    TestReopenTwoContexts();
+
+    if (g_failures)
+    {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All tests passed" << std::endl;
+    return 0;
+}